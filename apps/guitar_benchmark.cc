@@ -0,0 +1,258 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Runs the example effect chains headless under the GNU Radio
+ * scheduler, from a looping noise source into a null sink, and
+ * reports their throughput, the share of the CPU time taken by
+ * each block and the worst case latency of the buffers between
+ * them.
+ */
+
+#include <gnuradio/top_block.h>
+#include <gnuradio/block_detail.h>
+#include <gnuradio/buffer.h>
+#include <gnuradio/high_res_timer.h>
+#include <gnuradio/prefs.h>
+#include <gnuradio/blocks/vector_source_f.h>
+#include <gnuradio/blocks/head.h>
+#include <gnuradio/blocks/multiply_const_ff.h>
+#include <gnuradio/blocks/null_sink.h>
+#include <guitar/iir_interpolator.h>
+#include <guitar/iir_decimator.h>
+#include <guitar/distortion.h>
+#include <guitar/wah_filter.h>
+#include <guitar/shelving_filter.h>
+#include <guitar/flanger.h>
+#include <guitar/reverb.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+  const double SAMP_RATE = 44100.0;
+
+  // 10th order lowpass for x5 oversampling, from distortion_chain_ex.grc
+  const double FFTAPS_X5[] = {
+    0.00040246997599371843, -0.0018158326112469709, 0.004462495499446449,
+    -0.007321598828586269, 0.009335211042713355, -0.009953383793105623,
+    0.009335211042713362, -0.007321598828586287, 0.004462495499446459,
+    -0.001815832611246976, 0.0004024699759937197 };
+  const double FBTAPS_X5[] = {
+    1.0, -8.291059288298642, 31.968540091201724, -75.28500148906959,
+    119.70907498509254, -134.14207078838928, 107.20829278509079,
+    -60.32561513611677, 22.87426975190269, -5.280233075370271,
+    0.5639952704728106 };
+
+  // A block in a chain and the rate of its output in samples/sec
+  struct stage {
+    stage(const std::string& name_, gr::block_sptr blk_, double out_rate_):
+      name(name_), blk(blk_), out_rate(out_rate_) {}
+
+    std::string name;
+    gr::block_sptr blk;
+    double out_rate;
+  };
+
+  // The effect blocks of a chain, in order, with the settings of the
+  // example flowgraphs
+  std::vector<stage> make_chain(const std::string& name)
+  {
+    using namespace gr::guitar;
+    const std::vector<double> fftaps(FFTAPS_X5, FFTAPS_X5 + 11);
+    const std::vector<double> fbtaps(FBTAPS_X5, FBTAPS_X5 + 11);
+
+    std::vector<stage> chain;
+    if (name == "distortion") {
+      // distortion_chain_ex.grc
+      chain.push_back(stage("iir_interpolator",
+        iir_interpolator::make(5, fftaps, fbtaps), 5 * SAMP_RATE));
+      chain.push_back(stage("multiply_const",
+        gr::blocks::multiply_const_ff::make(5.0), 5 * SAMP_RATE));
+      chain.push_back(stage("distortion",
+        distortion::make(true, "S", 3.0, 0.5), 5 * SAMP_RATE));
+      chain.push_back(stage("iir_decimator",
+        iir_decimator::make(5, fftaps, fbtaps), SAMP_RATE));
+      chain.push_back(stage("shelving_filter",
+        shelving_filter::make(SAMP_RATE, "high-shelf", -15.0, 4000.0), SAMP_RATE));
+    } else if (name == "wah") {
+      // wah_wah_lfo_ex.grc
+      chain.push_back(stage("multiply_const",
+        gr::blocks::multiply_const_ff::make(1.0), SAMP_RATE));
+      chain.push_back(stage("wah_filter",
+        wah_filter::make(true, SAMP_RATE, "L", 750.0, 2500.0, 0.5, 0.4), SAMP_RATE));
+    } else if (name == "rig") {
+      chain.push_back(stage("shelving_filter",
+        shelving_filter::make(SAMP_RATE, "low-shelf", 6.0, 500.0), SAMP_RATE));
+      chain.push_back(stage("distortion",
+        distortion::make(true, "S", 3.0, 0.5), SAMP_RATE));
+      chain.push_back(stage("flanger",
+        flanger::make(true, SAMP_RATE, 0.020, 1.0, 0.5, "L"), SAMP_RATE));
+      chain.push_back(stage("reverb",
+        reverb::make(true, SAMP_RATE, "P", "P", 0.3), SAMP_RATE));
+    }
+    return chain;
+  }
+
+  // CPU time spent in work() so far, in seconds. Zero unless the
+  // performance counters are compiled in and enabled.
+  double work_time(const gr::block_sptr& blk)
+  {
+    return blk->pc_work_time_total() / gr::high_res_timer_tps();
+  }
+
+  // Longest time a sample spent queued in the output buffer of blk,
+  // in seconds, from the fullest the buffer got while running
+  double max_buffer_latency(const gr::block_sptr& blk, double out_rate)
+  {
+    if (!blk->detail() || blk->detail()->noutputs() == 0) {
+      return 0.0;
+    }
+    const double max_items =
+      blk->pc_output_buffers_full_max(0) * blk->detail()->output(0)->bufsize();
+    return max_items / out_rate;
+  }
+
+  // Runs num_channels copies of a chain in one flowgraph for nsamps
+  // input samples each, and prints the results
+  void run_chain(const std::string& name, size_t num_channels, size_t nsamps)
+  {
+    // One second of noise, looped
+    std::vector<float> noise(static_cast<size_t>(SAMP_RATE));
+    for (size_t i = 0; i < noise.size(); i++) {
+      noise[i] = 0.5f * ((rand() / (float)RAND_MAX) - 0.5f);
+    }
+
+    gr::top_block_sptr tb = gr::make_top_block("guitar_benchmark");
+    std::vector< std::vector<stage> > channels;
+    for (size_t c = 0; c < num_channels; c++) {
+      std::vector<stage> chain;
+      chain.push_back(stage("vector_source",
+        gr::blocks::vector_source_f::make(noise, true), SAMP_RATE));
+      chain.push_back(stage("head",
+        gr::blocks::head::make(sizeof(float), nsamps), SAMP_RATE));
+      const std::vector<stage> effects = make_chain(name);
+      chain.insert(chain.end(), effects.begin(), effects.end());
+      chain.push_back(stage("null_sink",
+        gr::blocks::null_sink::make(sizeof(float)), SAMP_RATE));
+
+      for (size_t s = 1; s < chain.size(); s++) {
+        tb->connect(chain[s - 1].blk, 0, chain[s].blk, 0);
+      }
+      channels.push_back(chain);
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    tb->run();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    // Per stage totals over all channels
+    const std::vector<stage>& stages = channels[0];
+    std::vector<double> cpu(stages.size(), 0.0), latency(stages.size(), 0.0);
+    double total_cpu = 0.0;
+    for (size_t c = 0; c < channels.size(); c++) {
+      for (size_t s = 0; s < stages.size(); s++) {
+        const double t = work_time(channels[c][s].blk);
+        cpu[s] += t;
+        total_cpu += t;
+        latency[s] = std::max(latency[s],
+          max_buffer_latency(channels[c][s].blk, channels[c][s].out_rate));
+      }
+    }
+
+    const double samps_per_sec = (num_channels * nsamps) / elapsed.count();
+    printf("chain %s: %lu channel(s) of %lu samples in %.3f s\n", name.c_str(),
+      (unsigned long)num_channels, (unsigned long)nsamps, elapsed.count());
+    printf("  end to end:  %14.0f samples/sec, %.1fx real time\n",
+      samps_per_sec, samps_per_sec / SAMP_RATE);
+    if (total_cpu > 0.0) {
+      printf("  work() time: %14.3f s of CPU, %.1f real time channels per core\n",
+        total_cpu, (num_channels * nsamps) / total_cpu / SAMP_RATE);
+    } else {
+      printf("  work() time: unavailable, performance counters are disabled\n");
+    }
+
+    printf("  %-20s %10s %18s\n", "block", "CPU share", "max latency (ms)");
+    double total_latency = 0.0;
+    for (size_t s = 0; s < stages.size(); s++) {
+      total_latency += latency[s];
+      if (total_cpu > 0.0) {
+        printf("  %-20s %9.1f%% %18.3f\n", stages[s].name.c_str(),
+          100.0 * cpu[s] / total_cpu, 1e3 * latency[s]);
+      } else {
+        printf("  %-20s %10s %18.3f\n", stages[s].name.c_str(), "-", 1e3 * latency[s]);
+      }
+    }
+    printf("  %-20s %10s %18.3f\n\n", "total", "", 1e3 * total_latency);
+  }
+
+} /* anonymous namespace */
+
+static void
+usage(const char* prog)
+{
+  fprintf(stderr,
+    "Usage: %s [--chain=distortion|wah|rig|all] [--channels=N] [--seconds=S]\n\n"
+    "  --chain     effect chain to run (default all)\n"
+    "  --channels  copies of the chain to run side by side (default 1)\n"
+    "  --seconds   audio to push through each copy at 44.1 kHz (default 60)\n", prog);
+}
+
+int
+main(int argc, char **argv)
+{
+  const char* chains[] = { "distortion", "wah", "rig" };
+  std::string chain = "all";
+  size_t num_channels = 1;
+  double seconds = 60.0;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg(argv[i]);
+    if (arg.compare(0, 8, "--chain=") == 0) {
+      chain = arg.substr(8);
+    } else if (arg.compare(0, 11, "--channels=") == 0) {
+      num_channels = strtoul(arg.c_str() + 11, NULL, 10);
+    } else if (arg.compare(0, 10, "--seconds=") == 0) {
+      seconds = strtod(arg.c_str() + 10, NULL);
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if ((chain != "all" && std::find(chains, chains + 3, chain) == chains + 3) ||
+      num_channels < 1 || seconds <= 0.0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  // Needed for the CPU share. Must be set before the flowgraph starts.
+  gr::prefs::singleton()->set_bool("PerfCounters", "on", true);
+
+  const size_t nsamps = static_cast<size_t>(seconds * SAMP_RATE);
+  for (size_t c = 0; c < 3; c++) {
+    if (chain == "all" || chain == chains[c]) {
+      run_chain(chains[c], num_channels, nsamps);
+    }
+  }
+  return 0;
+}
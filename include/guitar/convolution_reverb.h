@@ -0,0 +1,76 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2018 Ashish Chaudhari.
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GUITAR_CONVOLUTION_REVERB_H
+#define INCLUDED_GUITAR_CONVOLUTION_REVERB_H
+
+#include <guitar/api.h>
+#include <gnuradio/sync_block.h>
+
+namespace gr {
+  namespace guitar {
+
+    /*!
+     * \brief Reverb or cabinet simulation by convolution with a recorded
+     * impulse response
+     * \ingroup guitar
+     *
+     * Loads the impulse response from the WAV file ir_file, which must
+     * have the sample rate samp_rate. Multichannel files are mixed down
+     * to mono and the impulse response is normalized to unit energy.
+     *
+     * The convolution is computed with partitioned FFT convolution.
+     * The wet signal lags the input by partition_size samples (a power
+     * of two): smaller partitions lower the latency, larger ones lower
+     * the CPU load. The dry signal is not delayed, so with wet_gamma
+     * below 1 the latency acts as a pre-delay.
+     *
+     * Disabling the block fades to its input over a few ms. The
+     * convolution then freezes and the block costs no more than a copy,
+     * unless ring_out is set: then only the input of the convolution
+     * fades out and the tail decays over the dry signal until it is
+     * inaudible. A ring_out change during a fade or a tail applies
+     * once it is over.
+     */
+    class GUITAR_API convolution_reverb : virtual public gr::sync_block
+    {
+     public:
+      typedef boost::shared_ptr<convolution_reverb> sptr;
+
+      /*!
+       * \brief Return a shared_ptr to a new instance of guitar::convolution_reverb.
+       *
+       * To avoid accidental use of raw pointers, guitar::convolution_reverb's
+       * constructor is in a private implementation
+       * class. guitar::convolution_reverb::make is the public interface for
+       * creating new instances.
+       */
+      static sptr make(bool enabled, double samp_rate, const std::string& ir_file,
+          int partition_size, double wet_gamma, bool ring_out = false);
+
+      virtual void set_enabled(bool enabled) = 0;
+      virtual void set_wet_gamma(double wet_gamma) = 0;
+      virtual void set_ring_out(bool ring_out) = 0;
+    };
+
+  } // namespace guitar
+} // namespace gr
+
+#endif /* INCLUDED_GUITAR_CONVOLUTION_REVERB_H */
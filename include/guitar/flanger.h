@@ -32,6 +32,10 @@ namespace gr {
      * \brief <+description of block+>
      * \ingroup guitar
      *
+     * The interpolation mode selects how the delay line is read at the
+     * modulated (fractional) delay: "N" truncates the delay to whole
+     * samples, "L" interpolates linearly and "C" uses a cubic (third
+     * order Lagrange) interpolator.
      */
     class GUITAR_API flanger : virtual public gr::sync_block
     {
@@ -46,11 +50,13 @@ namespace gr {
        * class. guitar::flanger::make is the public interface for
        * creating new instances.
        */
-      static sptr make(bool enabled, double samp_rate, double max_delay, double lfo_freq, double wet_gamma);
+      static sptr make(bool enabled, double samp_rate, double max_delay, double lfo_freq, double wet_gamma,
+          std::string interp = "L");
 
       virtual void set_enabled(bool enabled) = 0;
       virtual void set_lfo_freq(double lfo_freq) = 0;
       virtual void set_wet_gamma(double wet_gamma) = 0;
+      virtual void set_interp(std::string interp) = 0;
     };
 
   } // namespace guitar
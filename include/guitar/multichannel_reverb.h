@@ -0,0 +1,91 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2018 Ashish Chaudhari.
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_GUITAR_MULTICHANNEL_REVERB_H
+#define INCLUDED_GUITAR_MULTICHANNEL_REVERB_H
+
+#include <guitar/api.h>
+#include <gnuradio/sync_block.h>
+
+namespace gr {
+  namespace guitar {
+
+    /*!
+     * \brief Reverb for many mono channels in a single block
+     * \ingroup guitar
+     *
+     * Applies the reverb effect independently to each of
+     * num_channels input streams. The state of all channels lives in
+     * one contiguous arena and the channels are processed one after
+     * another, so a single scheduler thread serves all of them.
+     *
+     * Coefficient mode changes are built in the caller's thread and
+     * swapped in by work() without blocking, optionally crossfading
+     * over crossfade_len samples.
+     *
+     * With single_precision the filter state is kept in floats
+     * instead of doubles, halving the size of the arena.
+     *
+     * fdn_size is 0 for the Schroeder comb bank, or 4, 8 or 16 for a
+     * feedback delay network with that many delay lines per channel.
+     *
+     * The randomized ("R") coefficient modes draw from a generator of
+     * this instance seeded with seed. Channels draw one after another,
+     * so the same seed always gives the same designs.
+     *
+     * Disabling the block fades all channels to their inputs over a few
+     * ms. The filters then freeze and the block costs no more than a
+     * copy per channel, unless ring_out is set: then only the input of
+     * the reverb fades out and the tails decay over the dry signals
+     * until they are inaudible. A ring_out change during a fade or a
+     * tail applies once it is over.
+     */
+    class GUITAR_API multichannel_reverb : virtual public gr::sync_block
+    {
+     public:
+      typedef boost::shared_ptr<multichannel_reverb> sptr;
+
+      /*!
+       * \brief Return a shared_ptr to a new instance of guitar::multichannel_reverb.
+       *
+       * To avoid accidental use of raw pointers, guitar::multichannel_reverb's
+       * constructor is in a private implementation
+       * class. guitar::multichannel_reverb::make is the public interface for
+       * creating new instances.
+       */
+      static sptr make(bool enabled, double samp_rate, int num_channels,
+          const std::string& comb_coeff_mode, const std::string& allpass_coeff_mode,
+          double wet_gamma, int crossfade_len = 0, bool single_precision = false,
+          int fdn_size = 0, int seed = 0, bool ring_out = false);
+
+      virtual void set_enabled(bool enabled) = 0;
+      virtual void set_comb_coeff_mode(const std::string& comb_coeff_mode) = 0;
+      virtual void set_allpass_coeff_mode(const std::string& allpass_coeff_mode) = 0;
+      virtual void set_wet_gamma(double wet_gamma) = 0;
+      virtual void set_crossfade_len(int crossfade_len) = 0;
+      virtual void set_ring_out(bool ring_out) = 0;
+    };
+
+  } // namespace guitar
+} // namespace gr
+
+#endif /* INCLUDED_GUITAR_MULTICHANNEL_REVERB_H */
+
@@ -0,0 +1,67 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2018 Ashish Chaudhari.
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GUITAR_PARAMETRIC_EQ_H
+#define INCLUDED_GUITAR_PARAMETRIC_EQ_H
+
+#include <guitar/api.h>
+#include <gnuradio/sync_block.h>
+
+namespace gr {
+  namespace guitar {
+
+    /*!
+     * \brief Cascade of EQ sections in a single block
+     * \ingroup guitar
+     *
+     * Runs num_channels streams through the same cascade of second
+     * order sections. Section i is described by types[i] (one of
+     * "low-shelf", "high-shelf", "peaking", "lowpass", "highpass"),
+     * gains[i] in dB, cutoff_freqs[i] in Hz and qs[i]. A single
+     * low-shelf or high-shelf section with q = 1/sqrt(2) is the same
+     * filter as guitar::shelving_filter.
+     */
+    class GUITAR_API parametric_eq : virtual public gr::sync_block
+    {
+     public:
+      typedef boost::shared_ptr<parametric_eq> sptr;
+
+      /*!
+       * \brief Return a shared_ptr to a new instance of guitar::parametric_eq.
+       *
+       * To avoid accidental use of raw pointers, guitar::parametric_eq's
+       * constructor is in a private implementation
+       * class. guitar::parametric_eq::make is the public interface for
+       * creating new instances.
+       */
+      static sptr make(double samp_rate, int num_channels,
+          const std::vector<std::string> &types, const std::vector<double> &gains,
+          const std::vector<double> &cutoff_freqs, const std::vector<double> &qs);
+
+      virtual void set_sections(const std::vector<std::string> &types,
+          const std::vector<double> &gains,
+          const std::vector<double> &cutoff_freqs,
+          const std::vector<double> &qs) = 0;
+    };
+
+  } // namespace guitar
+} // namespace gr
+
+#endif /* INCLUDED_GUITAR_PARAMETRIC_EQ_H */
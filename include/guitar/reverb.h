@@ -32,6 +32,28 @@ namespace gr {
      * \brief <+description of block+>
      * \ingroup guitar
      *
+     * Changing a coefficient mode designs and allocates the new
+     * filters in the caller's thread. work() swaps them in without
+     * blocking and, if crossfade_len is non-zero, fades from the tail
+     * of the old filters to the new ones over crossfade_len samples.
+     *
+     * With single_precision the filter state is kept in floats
+     * instead of doubles, which halves the memory the delay lines
+     * occupy at the cost of a lower noise floor in the reverb tail.
+     *
+     * fdn_size selects the algorithm: 0 for the Schroeder comb bank,
+     * or 4, 8 or 16 for a feedback delay network with that many delay
+     * lines. Larger networks give a denser tail and cost more CPU.
+     *
+     * The randomized ("R") coefficient modes draw from a generator of
+     * this instance seeded with seed, so the same seed always gives the
+     * same sequence of designs.
+     *
+     * Disabling the block fades to its input over a few ms. The filters
+     * then freeze and the block costs no more than a copy, unless
+     * ring_out is set: then only the input of the reverb fades out and
+     * the tail decays over the dry signal until it is inaudible. A
+     * ring_out change during a fade or a tail applies once it is over.
      */
     class GUITAR_API reverb : virtual public gr::sync_block
     {
@@ -48,7 +70,15 @@ namespace gr {
        */
       static sptr make(bool enabled, double samp_rate,
           const std::string& comb_coeff_mode, const std::string& allpass_coeff_mode,
-          double wet_gamma);
+          double wet_gamma, int crossfade_len = 0, bool single_precision = false,
+          int fdn_size = 0, int seed = 0, bool ring_out = false);
+
+      virtual void set_enabled(bool enabled) = 0;
+      virtual void set_comb_coeff_mode(const std::string& comb_coeff_mode) = 0;
+      virtual void set_allpass_coeff_mode(const std::string& allpass_coeff_mode) = 0;
+      virtual void set_wet_gamma(double wet_gamma) = 0;
+      virtual void set_crossfade_len(int crossfade_len) = 0;
+      virtual void set_ring_out(bool ring_out) = 0;
     };
 
   } // namespace guitar
@@ -32,6 +32,10 @@ namespace gr {
      * \brief <+description of block+>
      * \ingroup guitar
      *
+     * The setters may be called from any single controller thread
+     * while the flowgraph runs. New coefficients are handed to work()
+     * without locking and, if ramp_len is non-zero, are approached
+     * linearly over ramp_len samples instead of switching at once.
      */
     class GUITAR_API shelving_filter : virtual public gr::sync_block
     {
@@ -46,11 +50,13 @@ namespace gr {
        * class. guitar::shelving_filter::make is the public interface for
        * creating new instances.
        */
-      static sptr make(double samp_rate, std::string type, double gain, double cutoff_freq);
+      static sptr make(double samp_rate, std::string type, double gain, double cutoff_freq,
+          int ramp_len = 0);
 
       virtual void set_type(const std::string& type) = 0;
       virtual void set_gain(const double& gain) = 0;
       virtual void set_cutoff_freq(const double& cutoff_freq) = 0;
+      virtual void set_ramp_len(int ramp_len) = 0;
 };
 
   } // namespace guitar
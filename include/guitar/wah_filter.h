@@ -32,6 +32,9 @@ namespace gr {
      * \brief <+description of block+>
      * \ingroup guitar
      *
+     * The cutoff frequency is updated every control_period samples
+     * and ramped linearly in between. A control_period of 1 updates
+     * it for every sample.
      */
     class GUITAR_API wah_filter : virtual public gr::sync_block
     {
@@ -52,13 +55,15 @@ namespace gr {
           double cutoff_freq_min,
           double cutoff_freq_max,
           double lfo_freq,
-          double damp);
+          double damp,
+          int control_period = 1);
 
       virtual void set_enabled(double enabled) = 0;
       virtual void set_cutoff_freq_min(double cutoff_freq_min) = 0;
       virtual void set_cutoff_freq_max(double cutoff_freq_max) = 0;
       virtual void set_lfo_freq(double lfo_freq) = 0;
       virtual void set_damp(double damp) = 0;
+      virtual void set_control_period(int control_period) = 0;
     };
   } // namespace guitar
 } // namespace gr
@@ -0,0 +1,966 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <guitar/reverb.h>
+#include <guitar/multichannel_reverb.h>
+#include <guitar/convolution_reverb.h>
+#include <guitar/distortion.h>
+#include <guitar/oversampled_distortion.h>
+#include <guitar/wah_filter.h>
+#include <guitar/flanger.h>
+#include <guitar/shelving_filter.h>
+#include <guitar/parametric_eq.h>
+#include <guitar/iir_interpolator.h>
+#include <guitar/iir_decimator.h>
+#include <boost/circular_buffer.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC
+#endif
+#include "sparse_iir_filter.h"
+#include "comb_bank.h"
+#include "polyphase_iir_filter.h"
+#include "waveshaper.h"
+#include "biquad_cascade.h"
+#include "reverb_kernel.h"
+#include "partitioned_convolver.h"
+#include "denormal.h"
+
+using namespace gr::guitar;
+
+namespace {
+
+  // The per-sample boost::circular_buffer implementation that
+  // sparse_iir_filter replaced. Kept here as the baseline.
+  class legacy_sparse_iir_filter
+  {
+  public:
+    legacy_sparse_iir_filter(size_t num_taps, double ff_first, double ff_last, double fb_last):
+      d_prev_input(num_taps - 1), d_prev_output(num_taps - 1),
+      d_ff_first(ff_first), d_ff_last(ff_last), d_fb_last(fb_last)
+    {
+      for (size_t i = 0; i < d_prev_input.capacity(); i++) {
+        d_prev_input.push_back(0.0);
+        d_prev_output.push_back(0.0);
+      }
+    }
+
+    float filter(const float input)
+    {
+      double output = d_fb_last * d_prev_output.front();
+      output += d_ff_first * static_cast<double>(input);
+      output += d_ff_last * static_cast<double>(d_prev_input.front());
+      d_prev_input.push_back(input);
+      d_prev_output.push_back(output);
+      return static_cast<float>(output);
+    }
+
+  private:
+    boost::circular_buffer<float>  d_prev_input;
+    boost::circular_buffer<double> d_prev_output;
+    double d_ff_first, d_ff_last, d_fb_last;
+  };
+
+  // Direct form I IIR filter with the same structure as
+  // filter::kernel::iir_filter. Baseline for the resamplers.
+  class legacy_iir_filter
+  {
+  public:
+    legacy_iir_filter(const std::vector<double>& fftaps, const std::vector<double>& fbtaps):
+      d_fftaps(fftaps), d_fbtaps(fbtaps),
+      d_prev_input(2 * fftaps.size(), 0.0), d_prev_output(2 * fbtaps.size(), 0.0),
+      d_latest_n(0), d_latest_m(0)
+    {
+      for (size_t i = 1; i < d_fbtaps.size(); i++) {
+        d_fbtaps[i] = -fbtaps[i];
+      }
+    }
+
+    float filter(const float input)
+    {
+      const int n = d_fftaps.size();
+      const int m = d_fbtaps.size();
+      double acc = d_fftaps[0] * input;
+      for (int i = 1; i < n; i++) {
+        acc += d_fftaps[i] * d_prev_input[d_latest_n + i];
+      }
+      for (int i = 1; i < m; i++) {
+        acc += d_fbtaps[i] * d_prev_output[d_latest_m + i];
+      }
+      d_prev_output[d_latest_m] = acc;
+      d_prev_output[d_latest_m + m] = acc;
+      d_prev_input[d_latest_n] = input;
+      d_prev_input[d_latest_n + n] = input;
+      if (--d_latest_n < 0) d_latest_n += n;
+      if (--d_latest_m < 0) d_latest_m += m;
+      return static_cast<float>(acc);
+    }
+
+  private:
+    std::vector<double> d_fftaps, d_fbtaps;
+    std::vector<double> d_prev_input, d_prev_output;
+    int d_latest_n, d_latest_m;
+  };
+
+  // 10th order lowpass for x5 oversampling, from distortion_chain_ex.grc
+  const double FFTAPS_X5[] = {
+    0.00040246997599371843, -0.0018158326112469709, 0.004462495499446449,
+    -0.007321598828586269, 0.009335211042713355, -0.009953383793105623,
+    0.009335211042713362, -0.007321598828586287, 0.004462495499446459,
+    -0.001815832611246976, 0.0004024699759937197 };
+  const double FBTAPS_X5[] = {
+    1.0, -8.291059288298642, 31.968540091201724, -75.28500148906959,
+    119.70907498509254, -134.14207078838928, 107.20829278509079,
+    -60.32561513611677, 22.87426975190269, -5.280233075370271,
+    0.5639952704728106 };
+
+  // Runs func(in, out, n) over nsamps samples in blocks of block_size
+  // and returns the throughput in samples/sec
+  template<class F>
+  double measure(F func, size_t block_size, size_t nsamps)
+  {
+    std::vector<float> in(block_size), out(block_size);
+    for (size_t i = 0; i < block_size; i++) {
+      in[i] = (rand() / (float)RAND_MAX) - 0.5f;
+    }
+    const size_t nblocks = nsamps / block_size;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < nblocks; b++) {
+      func(&in[0], &out[0], block_size);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return (nblocks * block_size) / elapsed.count();
+  }
+
+  enum output_format { TABLE, CSV, JSON };
+
+  struct result {
+    std::string suite;
+    std::string name;
+    size_t block_size;
+    double samps_per_sec;
+    double speedup;       // Zero if there is no baseline
+  };
+
+  output_format format = TABLE;
+  const char* suite = "";
+  double tsc_hz = 0.0;    // Zero if there is no time stamp counter
+  std::vector<result> results;
+
+  // Time stamp counter ticks per second. The counter runs at a fixed
+  // rate on current x86 parts, so cycles/sample are reference cycles:
+  // they differ from core cycles when the clock is boosted or throttled.
+  double calibrate_tsc()
+  {
+#ifdef BENCH_HAVE_TSC
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const unsigned long long tsc_start = __rdtsc();
+    std::chrono::duration<double> elapsed;
+    do {
+      elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < 0.2);
+    return (__rdtsc() - tsc_start) / elapsed.count();
+#else
+    return 0.0;
+#endif
+  }
+
+  // Records a measurement. Tables are printed as they go, CSV and
+  // JSON once everything has run.
+  void report(const char* name, size_t block_size, double samps_per_sec, double baseline)
+  {
+    result r;
+    r.suite = suite;
+    r.name = name;
+    r.block_size = block_size;
+    r.samps_per_sec = samps_per_sec;
+    r.speedup = (baseline > 0.0) ? (samps_per_sec / baseline) : 0.0;
+    results.push_back(r);
+    if (format != TABLE) {
+      return;
+    }
+
+    char cycles[16] = "-", speedup[16] = "-";
+    if (tsc_hz > 0.0) {
+      snprintf(cycles, sizeof(cycles), "%.1f", tsc_hz / samps_per_sec);
+    }
+    if (r.speedup > 0.0) {
+      snprintf(speedup, sizeof(speedup), "%.2fx", r.speedup);
+    }
+    printf("%-46s %8lu %14.0f %10.2f %13s %9s\n", name, (unsigned long)block_size,
+      samps_per_sec, 1e9 / samps_per_sec, cycles, speedup);
+  }
+
+  void print_table_header(const char* title)
+  {
+    if (format == TABLE) {
+      printf("%-46s %8s %14s %10s %13s %9s\n", title, "block", "samples/sec",
+        "ns/sample", "cycles/sample", "speedup");
+    }
+  }
+
+  std::string json_escape(const std::string& str)
+  {
+    std::string escaped;
+    for (size_t i = 0; i < str.size(); i++) {
+      if (str[i] == '"' || str[i] == '\\') {
+        escaped += '\\';
+      }
+      escaped += str[i];
+    }
+    return escaped;
+  }
+
+  void print_results(size_t nsamps)
+  {
+    if (format == CSV) {
+      printf("suite,name,block_size,samples_per_sec,ns_per_sample,cycles_per_sample,speedup\n");
+      for (size_t i = 0; i < results.size(); i++) {
+        const result& r = results[i];
+        printf("%s,\"%s\",%lu,%.1f,%.4f,", r.suite.c_str(), r.name.c_str(),
+          (unsigned long)r.block_size, r.samps_per_sec, 1e9 / r.samps_per_sec);
+        if (tsc_hz > 0.0) printf("%.4f", tsc_hz / r.samps_per_sec);
+        printf(",");
+        if (r.speedup > 0.0) printf("%.4f", r.speedup);
+        printf("\n");
+      }
+    } else if (format == JSON) {
+      printf("{\n  \"nsamps\": %lu,\n  \"tsc_hz\": ", (unsigned long)nsamps);
+      if (tsc_hz > 0.0) printf("%.0f", tsc_hz); else printf("null");
+      printf(",\n  \"results\": [");
+      for (size_t i = 0; i < results.size(); i++) {
+        const result& r = results[i];
+        printf("%s\n    {\"suite\": \"%s\", \"name\": \"%s\", \"block_size\": %lu, "
+          "\"samples_per_sec\": %.1f, \"ns_per_sample\": %.4f, \"cycles_per_sample\": ",
+          (i > 0) ? "," : "", r.suite.c_str(), json_escape(r.name).c_str(),
+          (unsigned long)r.block_size, r.samps_per_sec, 1e9 / r.samps_per_sec);
+        if (tsc_hz > 0.0) printf("%.4f", tsc_hz / r.samps_per_sec); else printf("null");
+        printf(", \"speedup\": ");
+        if (r.speedup > 0.0) printf("%.4f", r.speedup); else printf("null");
+        printf("}");
+      }
+      printf("\n  ]\n}\n");
+    }
+  }
+
+  void bench_sparse_iir_filter(size_t block_size, size_t nsamps)
+  {
+    // Longest comb filter in the reverb "P" profile at 44.1 kHz
+    const size_t num_taps = 1120;
+    legacy_sparse_iir_filter legacy(num_taps, 0.0, 1.0, -0.764);
+    sparse_iir_filter<float,float,double> filt_1(num_taps, 0.0, 1.0, -0.764);
+    sparse_iir_filter<float,float,double> filt_n(num_taps, 0.0, 1.0, -0.764);
+
+    const double baseline = measure([&](const float* in, float* out, size_t n) {
+      for (size_t i = 0; i < n; i++) out[i] = legacy.filter(in[i]);
+    }, block_size, nsamps);
+    const double per_sample = measure([&](const float* in, float* out, size_t n) {
+      for (size_t i = 0; i < n; i++) out[i] = filt_1.filter(in[i]);
+    }, block_size, nsamps);
+    const double per_block = measure([&](const float* in, float* out, size_t n) {
+      filt_n.filter_n(in, out, n);
+    }, block_size, nsamps);
+
+    report("sparse_iir_filter (legacy)", block_size, baseline, baseline);
+    report("sparse_iir_filter::filter", block_size, per_sample, baseline);
+    report("sparse_iir_filter::filter_n", block_size, per_block, baseline);
+  }
+
+  void bench_comb_bank(size_t block_size, size_t nsamps)
+  {
+    // Comb filters of the reverb "P" profile at 44.1 kHz
+    const size_t num_taps[] = {899, 776, 1009, 1120};
+    const double gain[] = {0.805, 0.827, 0.783, 0.764};
+    std::vector< sparse_iir_filter<float,float,double>* > filters;
+    comb_bank<double, 4> bank(1120);
+    for (size_t c = 0; c < 4; c++) {
+      filters.push_back(new sparse_iir_filter<float,float,double>(num_taps[c], 0.0, 1.0, -gain[c]));
+      bank.set_taps(c, num_taps[c] - 1, 1.0, -gain[c]);
+    }
+    std::vector<float> tmp(block_size);
+
+    const double baseline = measure([&](const float* in, float* out, size_t n) {
+      std::fill(out, out + n, 0.0f);
+      for (size_t c = 0; c < filters.size(); c++) {
+        filters[c]->filter_n(in, &tmp[0], n);
+        for (size_t i = 0; i < n; i++) out[i] += tmp[i];
+      }
+    }, block_size, nsamps);
+    const double banked = measure([&](const float* in, float* out, size_t n) {
+      bank.filter_n(in, out, n);
+    }, block_size, nsamps);
+
+    report("4x sparse_iir_filter::filter_n", block_size, baseline, baseline);
+    report("comb_bank<double,4>::filter_n", block_size, banked, baseline);
+
+    for (size_t c = 0; c < filters.size(); c++) {
+      delete filters[c];
+    }
+  }
+
+  void bench_iir_interpolator(size_t block_size, size_t nsamps)
+  {
+    const unsigned interp = 5;
+    const std::vector<double> fftaps(FFTAPS_X5, FFTAPS_X5 + 11);
+    const std::vector<double> fbtaps(FBTAPS_X5, FBTAPS_X5 + 11);
+    legacy_iir_filter legacy(fftaps, fbtaps);
+    polyphase_iir_filter<float,float,double> poly(interp, fftaps, fbtaps);
+    std::vector<float> out(block_size * interp);
+
+    // Throughput is in input samples/sec
+    const double baseline = measure([&](const float* in, float*, size_t n) {
+      for (size_t i = 0; i < (n * interp); i++) {
+        out[i] = legacy.filter((i % interp == 0) ? in[i / interp] : 0.0);
+      }
+    }, block_size, nsamps);
+    const double polyphase = measure([&](const float* in, float*, size_t n) {
+      poly.interpolate(in, &out[0], n);
+    }, block_size, nsamps);
+
+    report("iir interpolate x5 (legacy)", block_size, baseline, baseline);
+    report("polyphase_iir_filter::interpolate", block_size, polyphase, baseline);
+  }
+
+  void bench_iir_decimator(size_t block_size, size_t nsamps)
+  {
+    const unsigned decim = 5;
+    const std::vector<double> fftaps(FFTAPS_X5, FFTAPS_X5 + 11);
+    const std::vector<double> fbtaps(FBTAPS_X5, FBTAPS_X5 + 11);
+    legacy_iir_filter legacy(fftaps, fbtaps);
+    polyphase_iir_filter<float,float,double> poly(decim, fftaps, fbtaps);
+
+    // Throughput is in input samples/sec. Both only consume whole
+    // groups of decim samples.
+    const double baseline = measure([&](const float* in, float* out, size_t n) {
+      for (size_t i = 0; i < (n - (n % decim)); i++) {
+        const float tmp = legacy.filter(in[i]);
+        if (i % decim == 0) {
+          out[i / decim] = tmp;
+        }
+      }
+    }, block_size, nsamps);
+    const double polyphase = measure([&](const float* in, float* out, size_t n) {
+      poly.decimate(in, out, n / decim);
+    }, block_size, nsamps);
+
+    report("iir decimate x5 (legacy)", block_size, baseline, baseline);
+    report("polyphase_iir_filter::decimate", block_size, polyphase, baseline);
+  }
+
+  void bench_waveshaper(size_t block_size, size_t nsamps)
+  {
+    const char* funcs[] = { "Q", "E", "S" };
+    for (size_t f = 0; f < 3; f++) {
+      waveshaper shaper(funcs[f], 2.0);
+      const double baseline = measure([&](const float* in, float* out, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+          out[i] = (0.5f * shaper.shape_exact(in[i])) + (0.5f * in[i]);
+        }
+      }, block_size, nsamps);
+      const double kernel = measure([&](const float* in, float* out, size_t n) {
+        shaper.process(in, out, n, true, 0.5);
+      }, block_size, nsamps);
+
+      const std::string name = std::string("waveshaper ") + funcs[f];
+      report((name + " (exact)").c_str(), block_size, baseline, baseline);
+      report((name + " (kernel)").c_str(), block_size, kernel, baseline);
+    }
+  }
+
+  void bench_oversampled_distortion(size_t block_size, size_t nsamps)
+  {
+    const unsigned factor = 5;
+    const size_t chunk_size = 256;
+    const std::vector<double> fftaps(FFTAPS_X5, FFTAPS_X5 + 11);
+    const std::vector<double> fbtaps(FBTAPS_X5, FBTAPS_X5 + 11);
+    std::vector<double> interp_taps(fftaps);
+    for (size_t i = 0; i < interp_taps.size(); i++) {
+      interp_taps[i] *= factor;
+    }
+    waveshaper shaper("S", 2.0);
+
+    // Three blocks connected through full-length buffers
+    polyphase_iir_filter<float,float,double> interp_a(factor, fftaps, fbtaps);
+    polyphase_iir_filter<float,float,double> decim_a(factor, fftaps, fbtaps);
+    std::vector<float> buff_a(block_size * factor), buff_b(block_size * factor);
+    const double baseline = measure([&](const float* in, float* out, size_t n) {
+      interp_a.interpolate(in, &buff_a[0], n);
+      for (size_t i = 0; i < (n * factor); i++) {
+        buff_a[i] *= factor;
+      }
+      shaper.process(&buff_a[0], &buff_b[0], n * factor, true, 0.5);
+      decim_a.decimate(&buff_b[0], out, n);
+    }, block_size, nsamps);
+
+    // Fused stages over a small scratch buffer
+    polyphase_iir_filter<float,float,double> interp_f(factor, interp_taps, fbtaps);
+    polyphase_iir_filter<float,float,double> decim_f(factor, fftaps, fbtaps);
+    std::vector<float> scratch(chunk_size * factor);
+    const double fused = measure([&](const float* in, float* out, size_t n) {
+      for (size_t offset = 0; offset < n; offset += chunk_size) {
+        const size_t nitems = std::min(chunk_size, n - offset);
+        interp_f.interpolate(in + offset, &scratch[0], nitems);
+        shaper.process(&scratch[0], &scratch[0], nitems * factor, true, 0.5);
+        decim_f.decimate(&scratch[0], out + offset, nitems);
+      }
+    }, block_size, nsamps);
+
+    report("x5 distortion, separate stages", block_size, baseline, baseline);
+    report("oversampled_distortion", block_size, fused, baseline);
+  }
+
+  void bench_parametric_eq(size_t block_size, size_t nsamps)
+  {
+    // Five band EQ on four channels
+    const size_t nchans = 4;
+    std::vector<biquad::coeffs> sections;
+    sections.push_back(biquad::design(biquad::HIGHPASS, 44100.0, 0.0, 80.0, 0.707));
+    sections.push_back(biquad::design(biquad::LOW_SHELF, 44100.0, 3.0, 200.0, 0.707));
+    sections.push_back(biquad::design(biquad::PEAKING, 44100.0, -4.0, 800.0, 1.5));
+    sections.push_back(biquad::design(biquad::PEAKING, 44100.0, 2.0, 2500.0, 1.0));
+    sections.push_back(biquad::design(biquad::HIGH_SHELF, 44100.0, -6.0, 6000.0, 0.707));
+    std::vector<double> z(2 * nchans * sections.size(), 0.0);
+
+    // One shelving_filter style block per section and channel
+    const double baseline = measure([&](const float* in, float* out, size_t n) {
+      for (size_t c = 0; c < nchans; c++) {
+        const float* x = in;
+        for (size_t s = 0; s < sections.size(); s++) {
+          const biquad::coeffs k = sections[s];
+          double z1 = z[(2 * ((c * sections.size()) + s)) + 0];
+          double z2 = z[(2 * ((c * sections.size()) + s)) + 1];
+          for (size_t i = 0; i < n; i++) {
+            out[i] = z1 + (x[i] * k.b0);
+            z1 = z2 + (x[i] * k.b1) - (out[i] * k.a1);
+            z2 = (x[i] * k.b2) - (out[i] * k.a2);
+          }
+          z[(2 * ((c * sections.size()) + s)) + 0] = z1;
+          z[(2 * ((c * sections.size()) + s)) + 1] = z2;
+          x = out;
+        }
+      }
+    }, block_size, nsamps);
+
+    biquad_cascade<double, 1> single;
+    single.set_sections(sections);
+    const double scalar = measure([&](const float* in, float* out, size_t n) {
+      for (size_t c = 0; c < nchans; c++) {
+        single.filter_n(&in, &out, n);
+      }
+    }, block_size, nsamps);
+
+    biquad_cascade<double, 4> lanes;
+    lanes.set_sections(sections);
+    const double vector = measure([&](const float* in, float* out, size_t n) {
+      const float* ins[nchans] = { in, in, in, in };
+      float* outs[nchans] = { out, out, out, out };
+      lanes.filter_n(ins, outs, n);
+    }, block_size, nsamps);
+
+    // Throughput is in samples/sec of all four channels
+    report("4ch x 5 chained biquads", block_size, baseline * nchans, baseline * nchans);
+    report("biquad_cascade<double,1> x 4", block_size, scalar * nchans, baseline * nchans);
+    report("biquad_cascade<double,4>", block_size, vector * nchans, baseline * nchans);
+  }
+
+  void bench_reverb_kernel(size_t block_size, size_t nsamps)
+  {
+    std::vector<reverb_kernel::filt_config> comb_cfgs, allpass_cfgs;
+    prng rng;
+    reverb_kernel::design(44100.0, "P", "P", 0, rng, comb_cfgs, allpass_cfgs);
+
+    reverb_kernel* kernel_d = reverb_kernel::make(44100.0, 0, false);
+    kernel_d->configure(comb_cfgs, allpass_cfgs);
+    const double baseline = measure([&](const float* in, float* out, size_t n) {
+      kernel_d->process(in, out, n);
+    }, block_size, nsamps);
+
+    reverb_kernel* kernel_f = reverb_kernel::make(44100.0, 0, true);
+    kernel_f->configure(comb_cfgs, allpass_cfgs);
+    const double single = measure([&](const float* in, float* out, size_t n) {
+      kernel_f->process(in, out, n);
+    }, block_size, nsamps);
+
+    delete kernel_d;
+    delete kernel_f;
+
+    report("reverb_kernel, double state", block_size, baseline, baseline);
+    report("reverb_kernel, float state", block_size, single, baseline);
+
+    // Feedback delay networks in place of the comb bank
+    for (size_t fdn_size = 4; fdn_size <= 16; fdn_size *= 2) {
+      reverb_kernel::design(44100.0, "P", "P", fdn_size, rng, comb_cfgs, allpass_cfgs);
+      reverb_kernel* kernel = reverb_kernel::make(44100.0, fdn_size, false);
+      kernel->configure(comb_cfgs, allpass_cfgs);
+      const double fdn = measure([&](const float* in, float* out, size_t n) {
+        kernel->process(in, out, n);
+      }, block_size, nsamps);
+      delete kernel;
+      char name[64];
+      snprintf(name, sizeof(name), "reverb_kernel, %lu line FDN", (unsigned long)fdn_size);
+      report(name, block_size, fdn, baseline);
+    }
+  }
+
+  void bench_partitioned_convolver(size_t block_size, size_t nsamps)
+  {
+    // Three second decaying noise impulse response at 44.1 kHz
+    std::vector<float> ir(3 * 44100);
+    for (size_t i = 0; i < ir.size(); i++) {
+      ir[i] = ((rand() / (float)RAND_MAX) - 0.5f) * exp(-(double)i / 20000.0) * 0.01;
+    }
+
+    // Time domain FIR. Too slow to run for long, so it only gets a
+    // small fraction of the samples.
+    std::vector<float> hist(2 * ir.size(), 0.0f);
+    size_t hist_idx = 0;
+    const double baseline = measure([&](const float* in, float* out, size_t n) {
+      for (size_t i = 0; i < n; i++) {
+        hist_idx = (hist_idx == 0) ? (ir.size() - 1) : (hist_idx - 1);
+        hist[hist_idx] = hist[hist_idx + ir.size()] = in[i];
+        const float* x = &hist[hist_idx];
+        float acc = 0.0f;
+        for (size_t k = 0; k < ir.size(); k++) {
+          acc += ir[k] * x[k];
+        }
+        out[i] = acc;
+      }
+    }, block_size, std::max(block_size, nsamps / 1024));
+    report("3s IR, time domain FIR", block_size, baseline, baseline);
+
+    for (size_t partition = 64; partition <= 1024; partition *= 4) {
+      partitioned_convolver conv(ir, partition);
+      const double fast = measure([&](const float* in, float* out, size_t n) {
+        conv.process(in, out, n);
+      }, block_size, nsamps);
+      char name[64];
+      snprintf(name, sizeof(name), "3s IR, partitioned, first %lu", (unsigned long)partition);
+      report(name, block_size, fast, baseline);
+    }
+  }
+
+  // SNR of the wet output of the single precision reverb kernel,
+  // taking the double precision kernel as the reference. For
+  // information only, qa_reverb_kernel asserts a minimum.
+  void report_reverb_snr(size_t nsamps)
+  {
+    std::vector<reverb_kernel::filt_config> comb_cfgs, allpass_cfgs;
+    prng rng;
+    reverb_kernel::design(44100.0, "P", "P", 0, rng, comb_cfgs, allpass_cfgs);
+    reverb_kernel* kernel_d = reverb_kernel::make(44100.0, 0, false);
+    reverb_kernel* kernel_f = reverb_kernel::make(44100.0, 0, true);
+    kernel_d->configure(comb_cfgs, allpass_cfgs);
+    kernel_f->configure(comb_cfgs, allpass_cfgs);
+
+    const size_t block_size = 1024;
+    std::vector<float> in(block_size), out_d(block_size), out_f(block_size);
+    double signal = 0.0, noise = 0.0;
+    for (size_t offset = 0; offset < nsamps; offset += block_size) {
+      for (size_t i = 0; i < block_size; i++) {
+        in[i] = (rand() / (float)RAND_MAX) - 0.5f;
+      }
+      kernel_d->process(&in[0], &out_d[0], block_size);
+      kernel_f->process(&in[0], &out_f[0], block_size);
+      for (size_t i = 0; i < block_size; i++) {
+        const double err = static_cast<double>(out_d[i]) - out_f[i];
+        signal += static_cast<double>(out_d[i]) * out_d[i];
+        noise += err * err;
+      }
+    }
+    delete kernel_d;
+    delete kernel_f;
+
+    printf("reverb_kernel float state SNR: %.1f dB over %lu samples\n\n",
+      10.0 * log10(signal / noise), (unsigned long)nsamps);
+  }
+
+  // Calls blk.work() over nsamps input samples in calls of block_size
+  // input items (rounded down to a multiple of decim). Every input
+  // stream gets the same noise. Returns the throughput in input
+  // samples/sec, counting the samples of every output channel.
+  double measure_work(gr::sync_block& blk, size_t ninputs, size_t noutputs,
+      size_t interp, size_t decim, size_t block_size, size_t nsamps)
+  {
+    block_size -= block_size % decim;
+    const size_t noutput_items = (block_size * interp) / decim;
+    std::vector<float> in(block_size);
+    for (size_t i = 0; i < block_size; i++) {
+      in[i] = (rand() / (float)RAND_MAX) - 0.5f;
+    }
+    std::vector< std::vector<float> > out(noutputs, std::vector<float>(noutput_items));
+    gr_vector_const_void_star input_items(ninputs, &in[0]);
+    gr_vector_void_star output_items;
+    for (size_t o = 0; o < noutputs; o++) {
+      output_items.push_back(&out[o][0]);
+    }
+
+    const size_t nblocks = std::max<size_t>(nsamps / block_size, 1);
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < nblocks; b++) {
+      blk.work(noutput_items, input_items, output_items);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return (nblocks * block_size * noutputs) / elapsed.count();
+  }
+
+  // Single channel block with one input and one output
+  double measure_work(gr::sync_block& blk, size_t block_size, size_t nsamps)
+  {
+    return measure_work(blk, 1, 1, 1, 1, block_size, nsamps);
+  }
+
+  // Every block's work() as the scheduler would call it, with the
+  // settings of the example flowgraphs at 44.1 kHz. Multichannel
+  // blocks count samples on all channels.
+  void bench_blocks(size_t block_size, size_t nsamps, const std::string& ir_file)
+  {
+    const double samp_rate = 44100.0;
+    const std::vector<double> fftaps(FFTAPS_X5, FFTAPS_X5 + 11);
+    const std::vector<double> fbtaps(FBTAPS_X5, FBTAPS_X5 + 11);
+
+    {
+      reverb::sptr blk = reverb::make(true, samp_rate, "P", "P", 0.3);
+      const double enabled = measure_work(*blk, block_size, nsamps);
+      report("reverb P/P", block_size, enabled, 0.0);
+      blk->set_enabled(false);
+      report("reverb P/P, bypassed", block_size, measure_work(*blk, block_size, nsamps), enabled);
+    }
+    {
+      reverb::sptr blk = reverb::make(true, samp_rate, "P", "P", 0.3, 0, true);
+      report("reverb P/P, float state", block_size, measure_work(*blk, block_size, nsamps), 0.0);
+    }
+    {
+      reverb::sptr blk = reverb::make(true, samp_rate, "P", "P", 0.3, 0, false, 8);
+      report("reverb P/P, 8 line FDN", block_size, measure_work(*blk, block_size, nsamps), 0.0);
+    }
+    {
+      multichannel_reverb::sptr blk = multichannel_reverb::make(true, samp_rate, 4, "P", "P", 0.3);
+      report("multichannel_reverb x4", block_size,
+        measure_work(*blk, 4, 4, 1, 1, block_size, nsamps), 0.0);
+    }
+    if (!ir_file.empty()) {
+      convolution_reverb::sptr blk = convolution_reverb::make(true, samp_rate, ir_file, 256, 0.3);
+      report("convolution_reverb, first 256", block_size,
+        measure_work(*blk, block_size, nsamps), 0.0);
+    }
+
+    const char* dist_funcs[] = { "L", "Q", "E", "I", "S" };
+    for (size_t f = 0; f < 5; f++) {
+      distortion::sptr blk = distortion::make(true, dist_funcs[f], 2.0, 0.5);
+      const std::string name = std::string("distortion ") + dist_funcs[f];
+      report(name.c_str(), block_size, measure_work(*blk, block_size, nsamps), 0.0);
+    }
+    {
+      oversampled_distortion::sptr blk =
+        oversampled_distortion::make(true, 5, fftaps, fbtaps, "S", 2.0, 0.5);
+      const double enabled = measure_work(*blk, block_size, nsamps);
+      report("oversampled_distortion x5 S", block_size, enabled, 0.0);
+      blk->set_enabled(false);
+      report("oversampled_distortion x5 S, bypassed", block_size,
+        measure_work(*blk, block_size, nsamps), enabled);
+    }
+
+    {
+      wah_filter::sptr blk = wah_filter::make(true, samp_rate, "L", 750.0, 2500.0, 0.5, 0.3, 16);
+      const double enabled = measure_work(*blk, block_size, nsamps);
+      report("wah_filter, LFO", block_size, enabled, 0.0);
+      blk->set_enabled(false);
+      report("wah_filter, LFO, bypassed", block_size,
+        measure_work(*blk, block_size, nsamps), enabled);
+    }
+    {
+      wah_filter::sptr blk = wah_filter::make(true, samp_rate, "S", 750.0, 2500.0, 0.5, 0.3, 16);
+      report("wah_filter, sidechain", block_size,
+        measure_work(*blk, 2, 1, 1, 1, block_size, nsamps), 0.0);
+    }
+    {
+      flanger::sptr blk = flanger::make(true, samp_rate, 0.020, 1.0, 0.5, "L");
+      const double enabled = measure_work(*blk, block_size, nsamps);
+      report("flanger", block_size, enabled, 0.0);
+      blk->set_enabled(false);
+      report("flanger, bypassed", block_size, measure_work(*blk, block_size, nsamps), enabled);
+    }
+
+    {
+      shelving_filter::sptr blk = shelving_filter::make(samp_rate, "low-shelf", 6.0, 500.0);
+      report("shelving_filter", block_size, measure_work(*blk, block_size, nsamps), 0.0);
+    }
+    {
+      std::vector<std::string> types;
+      types.push_back("highpass");
+      types.push_back("low-shelf");
+      types.push_back("peaking");
+      types.push_back("peaking");
+      types.push_back("high-shelf");
+      const double gains[] = { 0.0, 3.0, -4.0, 2.0, -6.0 };
+      const double cutoff_freqs[] = { 80.0, 200.0, 800.0, 2500.0, 6000.0 };
+      const double qs[] = { 0.707, 0.707, 1.5, 1.0, 0.707 };
+      parametric_eq::sptr blk = parametric_eq::make(samp_rate, 4, types,
+        std::vector<double>(gains, gains + 5),
+        std::vector<double>(cutoff_freqs, cutoff_freqs + 5),
+        std::vector<double>(qs, qs + 5));
+      report("parametric_eq x4, 5 bands", block_size,
+        measure_work(*blk, 4, 4, 1, 1, block_size, nsamps), 0.0);
+    }
+
+    {
+      iir_interpolator::sptr blk = iir_interpolator::make(5, fftaps, fbtaps);
+      report("iir_interpolator x5", block_size,
+        measure_work(*blk, 1, 1, 5, 1, block_size, nsamps), 0.0);
+    }
+    {
+      iir_decimator::sptr blk = iir_decimator::make(5, fftaps, fbtaps);
+      report("iir_decimator x5", block_size,
+        measure_work(*blk, 1, 1, 1, 5, block_size, nsamps), 0.0);
+    }
+  }
+
+  // Runs func over a burst of noise and then over nsamps samples of
+  // silence, and reports the throughput on the burst and on the second
+  // half of the silence, when the decaying state is at its smallest
+  template<class F>
+  void measure_decay(const std::string& name, F func, size_t nsamps)
+  {
+    const size_t block_size = 1024;
+    const size_t nburst = 1 << 16;
+    std::vector<float> noise(block_size), silence(block_size, 0.0f), out(block_size);
+    for (size_t i = 0; i < block_size; i++) {
+      noise[i] = (rand() / (float)RAND_MAX) - 0.5f;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < (nburst / block_size); b++) {
+      func(&noise[0], &out[0], block_size);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double burst = nburst / elapsed.count();
+
+    const size_t nblocks = std::max<size_t>(nsamps / block_size, 2);
+    for (size_t b = 0; b < (nblocks / 2); b++) {
+      func(&silence[0], &out[0], block_size);
+    }
+    start = std::chrono::steady_clock::now();
+    for (size_t b = (nblocks / 2); b < nblocks; b++) {
+      func(&silence[0], &out[0], block_size);
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    const double tail = ((nblocks - (nblocks / 2)) * block_size) / elapsed.count();
+
+    report((name + ", burst").c_str(), block_size, burst, burst);
+    report((name + ", silence").c_str(), block_size, tail, burst);
+  }
+
+  // Calls blk.work() with one input and one output stream, for blocks
+  // that consume decim input items per output item
+  class work_fn
+  {
+  public:
+    work_fn(gr::sync_block& blk, size_t decim = 1):
+      d_blk(blk), d_decim(decim), d_in(1), d_out(1) {}
+
+    void operator()(const float* in, float* out, size_t n)
+    {
+      d_in[0] = in;
+      d_out[0] = out;
+      d_blk.work(n / d_decim, d_in, d_out);
+    }
+
+  private:
+    gr::sync_block& d_blk;
+    const size_t d_decim;
+    gr_vector_const_void_star d_in;
+    gr_vector_void_star d_out;
+  };
+
+  // Cost of the recursive filters on the decaying tail after a note.
+  // The bare kernels are run with and without a denormal_guard, the
+  // blocks hold one in work(). A silence/burst ratio well below 1 is
+  // the subnormal slowdown.
+  void bench_silence(size_t nsamps)
+  {
+    std::vector<reverb_kernel::filt_config> comb_cfgs, allpass_cfgs;
+    prng rng;
+    reverb_kernel::design(44100.0, "P", "P", 0, rng, comb_cfgs, allpass_cfgs);
+    for (int single = 0; single < 2; single++) {
+      const std::string name = single ? "reverb_kernel, float state" : "reverb_kernel, double state";
+      reverb_kernel* kernel = reverb_kernel::make(44100.0, 0, single);
+      kernel->configure(comb_cfgs, allpass_cfgs);
+      measure_decay(name + ", no guard", [&](const float* in, float* out, size_t n) {
+        kernel->process(in, out, n);
+      }, nsamps);
+      kernel->reset();
+      measure_decay(name + ", guard", [&](const float* in, float* out, size_t n) {
+        denormal_guard guard;
+        kernel->process(in, out, n);
+      }, nsamps);
+      delete kernel;
+    }
+
+    std::vector<biquad::coeffs> sections;
+    sections.push_back(biquad::design(biquad::HIGHPASS, 44100.0, 0.0, 80.0, 0.707));
+    sections.push_back(biquad::design(biquad::LOW_SHELF, 44100.0, 3.0, 200.0, 0.707));
+    sections.push_back(biquad::design(biquad::PEAKING, 44100.0, -4.0, 800.0, 1.5));
+    sections.push_back(biquad::design(biquad::PEAKING, 44100.0, 2.0, 2500.0, 1.0));
+    sections.push_back(biquad::design(biquad::HIGH_SHELF, 44100.0, -6.0, 6000.0, 0.707));
+    biquad_cascade<double, 1> cascade;
+    cascade.set_sections(sections);
+    measure_decay("5 band biquad_cascade, no guard", [&](const float* in, float* out, size_t n) {
+      cascade.filter_n(&in, &out, n);
+    }, nsamps);
+    cascade.reset();
+    measure_decay("5 band biquad_cascade, guard", [&](const float* in, float* out, size_t n) {
+      denormal_guard guard;
+      cascade.filter_n(&in, &out, n);
+    }, nsamps);
+
+    const double samp_rate = 44100.0;
+    const std::vector<double> fftaps(FFTAPS_X5, FFTAPS_X5 + 11);
+    const std::vector<double> fbtaps(FBTAPS_X5, FBTAPS_X5 + 11);
+    {
+      reverb::sptr blk = reverb::make(true, samp_rate, "P", "P", 0.3);
+      measure_decay("reverb", work_fn(*blk), nsamps);
+    }
+    {
+      reverb::sptr blk = reverb::make(true, samp_rate, "P", "P", 0.3, 0, true);
+      measure_decay("reverb, float state", work_fn(*blk), nsamps);
+    }
+    {
+      shelving_filter::sptr blk = shelving_filter::make(samp_rate, "low-shelf", 6.0, 500.0);
+      measure_decay("shelving_filter", work_fn(*blk), nsamps);
+    }
+    {
+      wah_filter::sptr blk = wah_filter::make(true, samp_rate, "L", 750.0, 2500.0, 0.5, 0.3, 16);
+      measure_decay("wah_filter, LFO", work_fn(*blk), nsamps);
+    }
+    {
+      std::vector<std::string> types(1, "peaking");
+      parametric_eq::sptr blk = parametric_eq::make(samp_rate, 1, types,
+        std::vector<double>(1, 6.0), std::vector<double>(1, 800.0), std::vector<double>(1, 1.5));
+      measure_decay("parametric_eq", work_fn(*blk), nsamps);
+    }
+    {
+      iir_decimator::sptr blk = iir_decimator::make(5, fftaps, fbtaps);
+      measure_decay("iir_decimator x5", work_fn(*blk, 5), nsamps);
+    }
+  }
+
+} /* anonymous namespace */
+
+static void
+usage(const char* prog)
+{
+  fprintf(stderr,
+    "Usage: %s [--suite=kernels|blocks|silence|all] [--format=table|csv|json]\n"
+    "       [--ir=FILE] [NSAMPS]\n\n"
+    "  kernels  compares the DSP kernels with the code they replaced\n"
+    "  blocks   runs every block's work() over 64 to 65536 items per call\n"
+    "  silence  runs the recursive filters on silence after a burst\n"
+    "  --ir     impulse response WAV file, to include convolution_reverb\n"
+    "  NSAMPS   samples per measurement (default 16777216)\n", prog);
+}
+
+int
+main(int argc, char **argv)
+{
+  size_t nsamps = 1 << 24;
+  bool run_kernels = true, run_blocks = true, run_silence = true;
+  std::string ir_file;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg(argv[i]);
+    if (arg == "--suite=kernels") {
+      run_blocks = run_silence = false;
+    } else if (arg == "--suite=blocks") {
+      run_kernels = run_silence = false;
+    } else if (arg == "--suite=silence") {
+      run_kernels = run_blocks = false;
+    } else if (arg == "--suite=all") {
+      run_kernels = run_blocks = run_silence = true;
+    } else if (arg == "--format=table") {
+      format = TABLE;
+    } else if (arg == "--format=csv") {
+      format = CSV;
+    } else if (arg == "--format=json") {
+      format = JSON;
+    } else if (arg.compare(0, 5, "--ir=") == 0) {
+      ir_file = arg.substr(5);
+    } else if (!arg.empty() && isdigit(arg[0])) {
+      nsamps = strtoul(argv[i], NULL, 10);
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  tsc_hz = calibrate_tsc();
+
+  if (run_kernels) {
+    suite = "kernels";
+    if (format == TABLE) {
+      report_reverb_snr(nsamps);
+    }
+    print_table_header("kernel");
+    for (size_t block_size = 64; block_size <= 8192; block_size *= 8) {
+      bench_sparse_iir_filter(block_size, nsamps);
+      bench_comb_bank(block_size, nsamps);
+      bench_iir_interpolator(block_size, nsamps);
+      bench_iir_decimator(block_size, nsamps);
+      bench_waveshaper(block_size, nsamps);
+      bench_oversampled_distortion(block_size, nsamps);
+      bench_parametric_eq(block_size, nsamps);
+      bench_reverb_kernel(block_size, nsamps);
+      bench_partitioned_convolver(block_size, nsamps);
+    }
+  }
+
+  if (run_blocks) {
+    suite = "blocks";
+    if (format == TABLE && run_kernels) {
+      printf("\n");
+    }
+    print_table_header("block");
+    for (size_t block_size = 64; block_size <= 65536; block_size *= 4) {
+      bench_blocks(block_size, nsamps, ir_file);
+    }
+  }
+
+  if (run_silence) {
+    suite = "silence";
+    if (format == TABLE && (run_kernels || run_blocks)) {
+      printf("\n");
+    }
+    print_table_header("silence after a burst");
+    bench_silence(nsamps / 4);
+  }
+
+  print_results(nsamps);
+  return 0;
+}
@@ -0,0 +1,141 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cmath>
+#include "biquad.h"
+
+#define PI  3.14159265358979323846
+
+namespace gr {
+  namespace guitar {
+
+    bool
+    biquad::parse_type(const std::string& name, filt_type& type)
+    {
+      if (name == "low-shelf") {
+        type = LOW_SHELF;
+      } else if (name == "high-shelf") {
+        type = HIGH_SHELF;
+      } else if (name == "peaking") {
+        type = PEAKING;
+      } else if (name == "lowpass") {
+        type = LOWPASS;
+      } else if (name == "highpass") {
+        type = HIGHPASS;
+      } else {
+        return false;
+      }
+      return true;
+    }
+
+    biquad::coeffs
+    biquad::design(filt_type type, double samp_rate,
+        double gain, double cutoff_freq, double q)
+    {
+      coeffs c;
+
+      if (type == LOW_SHELF || type == HIGH_SHELF) {
+        double Q_inv = 1 / q;
+
+        double K = tan(PI * (cutoff_freq/samp_rate));
+        double K_sq = K * K;
+        double V0 = pow(10.0, (gain / 20));
+        if (V0 < 1) V0 = 1/V0;  // Invert gain if a cut
+
+        if (type == LOW_SHELF) {
+          if (gain >= 0.0) {
+            // Bass boost
+            c.b0 = (1 + sqrt(V0)*Q_inv*K + V0*K_sq) / (1 + Q_inv*K + K_sq);
+            c.b1 = (2 * (V0*K_sq - 1) ) / (1 + Q_inv*K + K_sq);
+            c.b2 = (1 - sqrt(V0)*Q_inv*K + V0*K_sq) / (1 + Q_inv*K + K_sq);
+            c.a1 = (2 * (K_sq - 1) ) / (1 + Q_inv*K + K_sq);
+            c.a2 = (1 - Q_inv*K + K_sq) / (1 + Q_inv*K + K_sq);
+          } else {
+            // Bass cut
+            c.b0 = (1 + Q_inv*K + K_sq) / (1 + Q_inv*sqrt(V0) *K + V0*K_sq);
+            c.b1 = (2 * (K_sq - 1) ) / (1 + Q_inv*sqrt(V0) *K + V0*K_sq);
+            c.b2 = (1 - Q_inv*K + K_sq) / (1 + Q_inv*sqrt(V0) *K + V0*K_sq);
+            c.a1 = (2 * (V0*K_sq - 1) ) / (1 + Q_inv*sqrt(V0) *K + V0*K_sq);
+            c.a2 = (1 - Q_inv*sqrt(V0) *K + V0*K_sq) / (1 + Q_inv*sqrt(V0) *K + V0*K_sq);
+          }
+        } else {
+          if (gain > 0) {
+            // Treble boost
+            c.b0 = (V0 + Q_inv*sqrt(V0) *K + K_sq) / (1 + Q_inv*K + K_sq);
+            c.b1 = (2 * (K_sq - V0) ) / (1 + Q_inv*K + K_sq);
+            c.b2 = (V0 - Q_inv*sqrt(V0) *K + K_sq) / (1 + Q_inv*K + K_sq);
+            c.a1 = (2 * (K_sq - 1) ) / (1 + Q_inv*K + K_sq);
+            c.a2 = (1 - Q_inv*K + K_sq) / (1 + Q_inv*K + K_sq);
+          } else {
+            // Treble cut
+            c.b0 = (1 + Q_inv*K + K_sq) / (V0 + Q_inv*sqrt(V0) *K + K_sq);
+            c.b1 = (2 * (K_sq - 1) ) / (V0 + Q_inv*sqrt(V0) *K + K_sq);
+            c.b2 = (1 - Q_inv*K + K_sq) / (V0 + Q_inv*sqrt(V0) *K + K_sq);
+            c.a1 = (2 * ((K_sq)/V0 - 1) ) / (1 + Q_inv/sqrt(V0) *K + (K_sq)/V0);
+            c.a2 = (1 - Q_inv/sqrt(V0) *K + (K_sq)/V0) / (1 + Q_inv/sqrt(V0) *K + (K_sq)/V0);
+          }
+        }
+        return c;
+      }
+
+      const double w0 = 2 * PI * (cutoff_freq / samp_rate);
+      const double cos_w0 = cos(w0);
+      const double alpha = sin(w0) / (2 * q);
+      double a0 = 1.0;
+
+      if (type == PEAKING) {
+        const double A = pow(10.0, (gain / 40));
+        c.b0 = 1 + (alpha * A);
+        c.b1 = -2 * cos_w0;
+        c.b2 = 1 - (alpha * A);
+        a0   = 1 + (alpha / A);
+        c.a1 = -2 * cos_w0;
+        c.a2 = 1 - (alpha / A);
+      } else {
+        // Lowpass or highpass, with the passband at the given gain
+        const double g = pow(10.0, (gain / 20));
+        if (type == LOWPASS) {
+          c.b0 = g * (1 - cos_w0) / 2;
+          c.b1 = g * (1 - cos_w0);
+          c.b2 = g * (1 - cos_w0) / 2;
+        } else {
+          c.b0 = g * (1 + cos_w0) / 2;
+          c.b1 = -g * (1 + cos_w0);
+          c.b2 = g * (1 + cos_w0) / 2;
+        }
+        a0   = 1 + alpha;
+        c.a1 = -2 * cos_w0;
+        c.a2 = 1 - alpha;
+      }
+
+      c.b0 /= a0;
+      c.b1 /= a0;
+      c.b2 /= a0;
+      c.a1 /= a0;
+      c.a2 /= a0;
+      return c;
+    }
+
+  } /* namespace guitar */
+} /* namespace gr */
@@ -0,0 +1,61 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GUITAR_BIQUAD_H
+#define INCLUDED_GUITAR_BIQUAD_H
+
+#include <string>
+
+namespace gr {
+  namespace guitar {
+
+    //  Coefficient design for second order sections. The sections are
+    //  normalized so that a0 = 1 and run in transposed direct form II:
+    //  y[n]  = z1[n-1] + b0*x[n]
+    //  z1[n] = z2[n-1] + b1*x[n] - a1*y[n]
+    //  z2[n] = b2*x[n] - a2*y[n]
+    //
+    //  Shelving filters use the Zolzer designs that shelving_filter has
+    //  always used. Peaking, lowpass and highpass sections use the RBJ
+    //  audio EQ cookbook designs.
+    class biquad
+    {
+     public:
+      enum filt_type { LOW_SHELF, HIGH_SHELF, PEAKING, LOWPASS, HIGHPASS };
+
+      struct coeffs {
+        coeffs(): b0(1.0), b1(0.0), b2(0.0), a1(0.0), a2(0.0) {}
+
+        double b0, b1, b2;  // Feedforward coefficients
+        double a1, a2;      // Feedback coefficients
+      };
+
+      //! Parse "low-shelf", "high-shelf", "peaking", "lowpass" or "highpass"
+      static bool parse_type(const std::string& name, filt_type& type);
+
+      //! Design a section. Parameters are assumed to be validated.
+      static coeffs design(filt_type type, double samp_rate,
+          double gain, double cutoff_freq, double q);
+    };
+
+  } // namespace guitar
+} // namespace gr
+
+#endif /* INCLUDED_GUITAR_BIQUAD_H */
@@ -0,0 +1,195 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_BIQUAD_CASCADE_H
+#define INCLUDED_BIQUAD_CASCADE_H
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "biquad.h"
+#include "simd.h"
+
+namespace gr {
+  namespace guitar {
+
+  /*!
+   * \brief a cascade of second order sections over N channels
+   *
+   * All channels run the same sections, each with its own state. The
+   * coefficients of all sections are held in one contiguous array and
+   * the state of all sections and channels in another, so the whole
+   * cascade stays cache resident.
+   *
+   * With N == 1 the cascade is run section by section over chunks of
+   * the input, keeping the state of one section in registers at a
+   * time. With N > 1 the channels are independent lanes of a GCC
+   * vector and every sample of all N channels runs through the
+   * cascade as one vector. Other compilers run the lanes one by one.
+   */
+  template<class state_type, size_t N = 1>
+  class biquad_cascade
+  {
+  public:
+    biquad_cascade() {}
+
+    /*!
+     * \brief install \p sections
+     *
+     * The state is kept if the number of sections is unchanged.
+     */
+    void set_sections(const std::vector<biquad::coeffs>& sections)
+    {
+      const bool resized = (sections.size() != num_sections());
+      d_coeffs.resize(5 * sections.size());
+      for (size_t s = 0; s < sections.size(); s++) {
+        d_coeffs[(5 * s) + 0] = sections[s].b0;
+        d_coeffs[(5 * s) + 1] = sections[s].b1;
+        d_coeffs[(5 * s) + 2] = sections[s].b2;
+        d_coeffs[(5 * s) + 3] = sections[s].a1;
+        d_coeffs[(5 * s) + 4] = sections[s].a2;
+      }
+      if (resized) {
+        reset();
+      }
+    }
+
+    size_t num_sections() const { return d_coeffs.size() / 5; }
+
+    /*!
+     * \brief filter \p n samples of each of the N channels
+     *
+     * \p input[c] and \p output[c] may point to the same buffer.
+     */
+    void filter_n(const float* const* input, float* const* output, size_t n)
+    {
+      _filter_n(input, output, n);
+    }
+
+    //! reset state to zero
+    void reset()
+    {
+      d_state.assign(2 * N * num_sections(), state_type(0.0));
+    }
+
+    //! take over the state of \p other, which has as many sections
+    void copy_state(const biquad_cascade& other)
+    {
+      std::copy(other.d_state.begin(), other.d_state.end(), d_state.begin());
+    }
+
+    //! add \p offset to the state of every section and channel
+    void offset_state(state_type offset)
+    {
+      for (size_t i = 0; i < d_state.size(); i++) {
+        d_state[i] += offset;
+      }
+    }
+
+  protected:
+    static const size_t CHUNK_SIZE = 256;
+
+#if defined(GUITAR_HAVE_VECTOR_EXT)
+    typedef state_type lanes_t __attribute__((vector_size(N * sizeof(state_type))));
+
+    void _filter_n(const float* const* input, float* const* output, size_t n)
+    {
+      // A single channel gains nothing from a one-lane vector
+      if (N == 1) {
+        _filter_channel(0, input[0], output[0], n);
+        return;
+      }
+
+      const size_t nsections = num_sections();
+      const state_type* coeffs = d_coeffs.data();
+      // The state vector is only guaranteed to be aligned to a single
+      // element, so lanes are moved in and out with memcpy
+      state_type* state = d_state.data();
+
+      for (size_t i = 0; i < n; i++) {
+        lanes_t x;
+        for (size_t c = 0; c < N; c++) x[c] = input[c][i];
+        for (size_t s = 0; s < nsections; s++) {
+          const state_type* k = &coeffs[5 * s];
+          state_type* z = &state[2 * s * N];
+          lanes_t z1, z2;
+          memcpy(&z1, z, sizeof(lanes_t));
+          memcpy(&z2, z + N, sizeof(lanes_t));
+          const lanes_t y = z1 + (k[0] * x);
+          z1 = z2 + (k[1] * x) - (k[3] * y);
+          z2 = (k[2] * x) - (k[4] * y);
+          memcpy(z, &z1, sizeof(lanes_t));
+          memcpy(z + N, &z2, sizeof(lanes_t));
+          x = y;
+        }
+        for (size_t c = 0; c < N; c++) output[c][i] = static_cast<float>(x[c]);
+      }
+    }
+#else
+    void _filter_n(const float* const* input, float* const* output, size_t n)
+    {
+      for (size_t c = 0; c < N; c++) {
+        _filter_channel(c, input[c], output[c], n);
+      }
+    }
+#endif
+
+    // Run the whole cascade on one channel, one section at a time
+    void _filter_channel(size_t chan, const float* input, float* output, size_t n)
+    {
+      const size_t nsections = num_sections();
+      state_type buff[CHUNK_SIZE];
+
+      for (size_t offset = 0; offset < n; offset += CHUNK_SIZE) {
+        const size_t nitems = std::min<size_t>(CHUNK_SIZE, n - offset);
+        for (size_t i = 0; i < nitems; i++) buff[i] = input[offset + i];
+
+        for (size_t s = 0; s < nsections; s++) {
+          const state_type b0 = d_coeffs[(5 * s) + 0], b1 = d_coeffs[(5 * s) + 1];
+          const state_type b2 = d_coeffs[(5 * s) + 2];
+          const state_type a1 = d_coeffs[(5 * s) + 3], a2 = d_coeffs[(5 * s) + 4];
+          state_type z1 = d_state[(2 * s * N) + chan];
+          state_type z2 = d_state[(((2 * s) + 1) * N) + chan];
+          for (size_t i = 0; i < nitems; i++) {
+            const state_type x = buff[i];
+            const state_type y = z1 + (b0 * x);
+            z1 = z2 + (b1 * x) - (a1 * y);
+            z2 = (b2 * x) - (a2 * y);
+            buff[i] = y;
+          }
+          d_state[(2 * s * N) + chan] = z1;
+          d_state[(((2 * s) + 1) * N) + chan] = z2;
+        }
+
+        for (size_t i = 0; i < nitems; i++) output[offset + i] = static_cast<float>(buff[i]);
+      }
+    }
+
+    std::vector<state_type> d_coeffs;   // b0, b1, b2, a1, a2 per section
+    std::vector<state_type> d_state;    // z1, z2 per section, lane-interleaved
+  };
+
+  template<class state_type, size_t N>
+  const size_t biquad_cascade<state_type, N>::CHUNK_SIZE;
+
+  } /* namespace guitar */
+} /* namespace gr */
+
+#endif /* INCLUDED_BIQUAD_CASCADE_H */
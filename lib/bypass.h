@@ -0,0 +1,163 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_BYPASS_H
+#define INCLUDED_BYPASS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include "param.h"
+
+namespace gr {
+  namespace guitar {
+
+  /*!
+   * \brief switches an effect between its output and a straight copy of
+   * its input, with a short crossfade on every change
+   *
+   * set_enabled() can be called from any thread. work() takes a
+   * snapshot() per buffer. While BYPASSED it should copy() its input
+   * and leave the state of the effect alone, so that a disabled block
+   * costs no more than a memcpy and its state is frozen until it is
+   * enabled again. While FADING it runs the effect as if enabled and
+   * then crossfade()s from the input to the effect output.
+   *
+   * The fade is linear and lasts fade_len samples whatever the buffer
+   * size: it can end inside a buffer, and the samples after it are at
+   * the new setting. A change during a fade turns it around from where
+   * it is, at the same rate.
+   *
+   * Effects with a long tail can let it ring out instead: they
+   * fade_input() into the effect, keep the dry signal at unity, and
+   * keep running on silence after the fade until tail_done().
+   */
+  class bypass
+  {
+  public:
+    static const int DEFAULT_FADE_LEN = 256;
+    //! Samples of faded input an effect should buffer at a time
+    static const size_t CHUNK_SIZE = 256;
+
+    enum state_t { BYPASSED, ACTIVE, FADING };
+
+    /*!
+     * \brief the fade over one buffer, from snapshot()
+     *
+     * Sample i (from 0) takes a share start + (i + 1) * step of the
+     * effect output for i < len, and a share target after that.
+     */
+    struct fade
+    {
+      float start;
+      float step;
+      size_t len;
+      float target;
+
+      //! Fade from in to the effect output held in out
+      void crossfade(const float* in, float* out, size_t n) const
+      {
+        const size_t nfade = std::min(len, n);
+        float mix = start;
+        for (size_t i = 0; i < nfade; i++) {
+          mix += step;
+          out[i] = in[i] + (mix * (out[i] - in[i]));
+        }
+        if (target == 0.0f) {
+          copy(in + nfade, out + nfade, n - nfade);
+        }
+      }
+
+      //! faded = in scaled by the fade, for the n samples from sample
+      //! pos of the buffer. in and faded may alias.
+      void fade_input(const float* in, float* faded, size_t n, size_t pos) const
+      {
+        for (size_t i = 0; i < n; i++) {
+          const float mix = ((pos + i) < len) ? (start + ((pos + i + 1) * step)) : target;
+          faded[i] = mix * in[i];
+        }
+      }
+    };
+
+    explicit bypass(bool enabled, int fade_len = DEFAULT_FADE_LEN):
+      d_enabled(enabled), d_fade_len(std::max(fade_len, 0)),
+      d_mix(enabled ? 1.0f : 0.0f), d_target(d_mix), d_step(0.0f), d_fade_left(0) {}
+
+    //! Any thread
+    void set_enabled(bool enabled) { d_enabled.set(enabled); }
+    bool enabled() const { return d_enabled.get(); }
+
+    //! take a snapshot for a buffer of \p n samples. work() only.
+    state_t snapshot(size_t n, fade& f)
+    {
+      const float target = d_enabled.get() ? 1.0f : 0.0f;
+      if (target != d_target) {
+        d_target = target;
+        d_fade_left = static_cast<size_t>(std::ceil(std::abs(target - d_mix) * d_fade_len));
+        if (d_fade_left == 0) {
+          d_mix = target;
+        } else {
+          d_step = (target - d_mix) / d_fade_left;
+        }
+      }
+
+      f.start = d_mix;
+      f.target = d_target;
+      if (d_fade_left == 0) {
+        f.step = 0.0f;
+        f.len = 0;
+        return (d_mix == 0.0f) ? BYPASSED : ACTIVE;
+      }
+      f.step = d_step;
+      f.len = std::min(n, d_fade_left);
+      d_fade_left -= f.len;
+      d_mix = (d_fade_left == 0) ? d_target : (d_mix + (f.len * d_step));
+      return FADING;
+    }
+
+    //! out = in. in and out may alias.
+    static void copy(const float* in, float* out, size_t n)
+    {
+      if (out != in) {
+        std::memcpy(out, in, n * sizeof(float));
+      }
+    }
+
+    //! True once the loudest sample of a tail in a buffer is below -100 dBFS
+    static bool tail_done(float peak)
+    {
+      return peak < 1e-5f;
+    }
+
+  private:
+    param<bool> d_enabled;
+    const int d_fade_len;
+    // Owned by work()
+    float d_mix;
+    float d_target;
+    float d_step;
+    size_t d_fade_left;
+  };
+
+  } /* namespace guitar */
+} /* namespace gr */
+
+#endif /* INCLUDED_BYPASS_H */
@@ -0,0 +1,242 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_COMB_BANK_H
+#define INCLUDED_COMB_BANK_H
+
+#include <boost/noncopyable.hpp>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "simd.h"
+
+namespace gr {
+  namespace guitar {
+
+  /*!
+   * \brief class template for a bank of N parallel comb filters
+   *
+   * Every lane computes y_c(n) = x(n-D_c)*ff_c + y_c(n-D_c)*fb_c on the
+   * same input and the bank outputs the sum over all lanes. All lanes
+   * share one input delay line and the output delay lines are stored
+   * lane-interleaved, so the N lanes of a sample are updated with a
+   * single vector multiply-add and a single store.
+   *
+   * The vector kernel uses GCC vector extensions, which map onto
+   * SSE/NEON. On x86 an AVX build of the same kernel is selected at
+   * runtime when the CPU supports it. Other compilers get the scalar
+   * kernel.
+   *
+   * Like sparse_iir_filter, the delay lines may be carved out of
+   * caller-provided memory of at least storage_size() bytes.
+   */
+  template<class state_type, size_t N = 4>
+  class comb_bank : boost::noncopyable
+  {
+  public:
+    /*!
+     * \brief construct a comb bank that supports delays up to \p max_delay
+     *
+     * All lanes start out with delay 1 and zero gain.
+     *
+     * \param storage memory of at least storage_size(max_delay) bytes
+     *        for the delay lines, or NULL to allocate internally.
+     */
+    comb_bank(size_t max_delay, void* storage = NULL):
+      d_mask(_next_pow2(std::max<size_t>(max_delay, 1)) - 1),
+      d_wr_idx(0)
+    {
+      if (storage == NULL) {
+        d_owned_storage.resize(storage_size(max_delay));
+        storage = &d_owned_storage[0];
+      }
+      d_prev_output = static_cast<state_type*>(storage);
+      d_prev_input = reinterpret_cast<float*>(
+        static_cast<char*>(storage) + _align((d_mask + 1) * N * sizeof(state_type)));
+
+      for (size_t c = 0; c < N; c++) {
+        set_taps(c, 1, 0.0, 0.0);
+      }
+      d_kernel = &comb_bank::_filter_n_generic;
+#if defined(GUITAR_HAVE_VECTOR_EXT)
+      d_kernel = &comb_bank::_filter_n_vector;
+#endif
+#if defined(GUITAR_HAVE_AVX_DISPATCH)
+      if (__builtin_cpu_supports("avx")) {
+        d_kernel = &comb_bank::_filter_n_avx;
+      }
+#endif
+      reset();
+    }
+
+    //! bytes of delay line storage needed by a bank with \p max_delay
+    static size_t storage_size(size_t max_delay)
+    {
+      const size_t buff_len = _next_pow2(std::max<size_t>(max_delay, 1));
+      return _align(buff_len * N * sizeof(state_type)) + _align(buff_len * sizeof(float));
+    }
+
+    /*!
+     * \brief install taps for comb \p lane.
+     *
+     * \p delay is clamped to [1, max_delay].
+     */
+    void set_taps(size_t lane, size_t delay, state_type ff_last, state_type fb_last)
+    {
+      d_delay[lane]   = std::min(std::max<size_t>(delay, 1), d_mask + 1);
+      d_ff_last[lane] = ff_last;
+      d_fb_last[lane] = fb_last;
+    }
+
+    /*!
+     * \brief compute \p n output values, each the sum of all lanes.
+     *
+     * \p input and \p output may point to the same buffer.
+     */
+    void filter_n(const float* input, float* output, size_t n)
+    {
+      (this->*d_kernel)(input, output, n);
+    }
+
+    //! reset state to zero
+    void reset()
+    {
+      std::fill(d_prev_input, d_prev_input + d_mask + 1, 0.0f);
+      std::fill(d_prev_output, d_prev_output + ((d_mask + 1) * N), state_type(0.0));
+      d_wr_idx = 0;
+    }
+
+  private:
+    typedef void (comb_bank::*kernel_t)(const float*, float*, size_t);
+
+    static size_t _next_pow2(size_t n)
+    {
+      size_t p = 1;
+      while (p < n) p <<= 1;
+      return p;
+    }
+
+    // Round up to a cache line so that every delay line is aligned
+    static size_t _align(size_t n)
+    {
+      return (n + 63) & ~static_cast<size_t>(63);
+    }
+
+    void _filter_n_generic(const float* input, float* output, size_t n)
+    {
+      for (size_t i = 0; i < n; i++) {
+        state_type acc = 0.0;
+        for (size_t c = 0; c < N; c++) {
+          const size_t rd_idx = (d_wr_idx - d_delay[c]) & d_mask;
+          const state_type y = (d_ff_last[c] * static_cast<state_type>(d_prev_input[rd_idx])) +
+                               (d_fb_last[c] * d_prev_output[(rd_idx * N) + c]);
+          d_prev_output[(d_wr_idx * N) + c] = y;
+          acc += y;
+        }
+        d_prev_input[d_wr_idx] = input[i];
+        d_wr_idx = (d_wr_idx + 1) & d_mask;
+        output[i] = static_cast<float>(acc);
+      }
+    }
+
+#if defined(GUITAR_HAVE_VECTOR_EXT)
+    typedef state_type lanes_t __attribute__((vector_size(N * sizeof(state_type))));
+
+    // Shared body of the vector kernels. Always inlined so that each
+    // caller is compiled for its own target instruction set.
+    inline __attribute__((always_inline))
+    void _filter_n_vector_body(const float* input, float* output, size_t n)
+    {
+      lanes_t ff, fb;
+      std::memcpy(&ff, d_ff_last, sizeof(lanes_t));
+      std::memcpy(&fb, d_fb_last, sizeof(lanes_t));
+      state_type* y_hist = d_prev_output;
+      float* x_hist = d_prev_input;
+
+      while (n > 0) {
+        // Longest run over which neither the write pointer nor any
+        // of the lane read pointers wraps
+        size_t run = std::min(n, d_mask + 1 - d_wr_idx);
+        const float* x_rd[N];
+        const state_type* y_rd[N];
+        for (size_t c = 0; c < N; c++) {
+          const size_t rd_idx = (d_wr_idx - d_delay[c]) & d_mask;
+          run = std::min(run, d_mask + 1 - rd_idx);
+          x_rd[c] = &x_hist[rd_idx];
+          y_rd[c] = &y_hist[(rd_idx * N) + c];
+        }
+        state_type* y_wr = &y_hist[d_wr_idx * N];
+        float* x_wr = &x_hist[d_wr_idx];
+
+        for (size_t i = 0; i < run; i++) {
+          lanes_t xv, yv;
+#pragma GCC unroll 16
+          for (size_t c = 0; c < N; c++) {
+            xv[c] = static_cast<state_type>(x_rd[c][i]);
+            yv[c] = y_rd[c][i * N];
+          }
+          const lanes_t y = (ff * xv) + (fb * yv);
+          std::memcpy(&y_wr[i * N], &y, sizeof(lanes_t));
+
+          state_type acc = 0.0;
+#pragma GCC unroll 16
+          for (size_t c = 0; c < N; c++) {
+            acc += y[c];
+          }
+          x_wr[i] = input[i];
+          output[i] = static_cast<float>(acc);
+        }
+
+        d_wr_idx = (d_wr_idx + run) & d_mask;
+        input += run;
+        output += run;
+        n -= run;
+      }
+    }
+
+    void _filter_n_vector(const float* input, float* output, size_t n)
+    {
+      _filter_n_vector_body(input, output, n);
+    }
+#endif
+
+#if defined(GUITAR_HAVE_AVX_DISPATCH)
+    __attribute__((target("avx")))
+    void _filter_n_avx(const float* input, float* output, size_t n)
+    {
+      _filter_n_vector_body(input, output, n);
+    }
+#endif
+
+    const size_t d_mask;
+    std::vector<char> d_owned_storage;
+    float*      d_prev_input;
+    state_type* d_prev_output;  // Lane-interleaved
+    size_t      d_wr_idx;
+    size_t      d_delay[N];
+    state_type  d_ff_last[N];
+    state_type  d_fb_last[N];
+    kernel_t    d_kernel;
+  };
+
+  } /* namespace guitar */
+} /* namespace gr */
+
+#endif /* INCLUDED_COMB_BANK_H */
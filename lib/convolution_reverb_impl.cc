@@ -0,0 +1,186 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2018 Ashish Chaudhari.
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include "denormal.h"
+#include "convolution_reverb_impl.h"
+#include "wav_file.h"
+
+namespace gr {
+  namespace guitar {
+
+    convolution_reverb::sptr
+    convolution_reverb::make(bool enabled, double samp_rate, const std::string& ir_file,
+        int partition_size, double wet_gamma, bool ring_out)
+    {
+      return gnuradio::get_initial_sptr
+        (new convolution_reverb_impl(enabled, samp_rate, ir_file, partition_size, wet_gamma,
+          ring_out));
+    }
+
+    /*
+     * The private constructor
+     */
+    convolution_reverb_impl::convolution_reverb_impl(bool enabled, double samp_rate,
+        const std::string& ir_file, int partition_size, double wet_gamma,
+        bool ring_out)
+      : gr::sync_block("convolution_reverb",
+        gr::io_signature::make(1, 1, sizeof(float)),
+        gr::io_signature::make(1, 1, sizeof(float))),
+        d_bypass(enabled), d_wet_gamma(wet_gamma), d_ring_out(ring_out), d_convolver(NULL),
+        d_ringing(enabled), d_cur_ring_out(ring_out)
+    {
+      setup_stats_port(this);
+      if (partition_size < 16 || partition_size > int(partitioned_convolver::MAX_PARTITION) ||
+          (partition_size & (partition_size - 1)) != 0) {
+        std::stringstream msg;
+        msg << "convolution_reverb: partition_size must be a power of two between 16 and "
+            << partitioned_convolver::MAX_PARTITION;
+        throw std::invalid_argument(msg.str());
+      }
+
+      std::vector<float> ir;
+      double ir_samp_rate;
+      wav_file::read(ir_file, ir, ir_samp_rate);
+      if (std::fabs(ir_samp_rate - samp_rate) > 0.5) {
+        std::stringstream msg;
+        msg << "convolution_reverb: " << ir_file << " has sample rate " << ir_samp_rate
+            << " Hz, not " << samp_rate << " Hz";
+        throw std::invalid_argument(msg.str());
+      }
+
+      // Unit energy, so that the wet signal is about as loud as the dry
+      double energy = 0.0;
+      for (size_t i = 0; i < ir.size(); i++) {
+        energy += double(ir[i]) * ir[i];
+      }
+      if (energy == 0.0) {
+        throw std::invalid_argument("convolution_reverb: " + ir_file + " is silent");
+      }
+      const float scale = 1.0 / std::sqrt(energy);
+      for (size_t i = 0; i < ir.size(); i++) {
+        ir[i] *= scale;
+      }
+
+      d_convolver = new partitioned_convolver(ir, partition_size);
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    convolution_reverb_impl::~convolution_reverb_impl()
+    {
+      delete d_convolver;
+    }
+
+    void
+    convolution_reverb_impl::set_enabled(bool enabled)
+    {
+      d_bypass.set_enabled(enabled);
+    }
+
+    void
+    convolution_reverb_impl::set_wet_gamma(double wet_gamma)
+    {
+      d_wet_gamma.set(wet_gamma);
+    }
+
+    void
+    convolution_reverb_impl::set_ring_out(bool ring_out)
+    {
+      d_ring_out.set(ring_out);
+    }
+
+    void
+    convolution_reverb_impl::setup_rpc()
+    {
+      setup_stats_rpc(this);
+    }
+
+    int
+    convolution_reverb_impl::work(int noutput_items,
+        gr_vector_const_void_star &input_items,
+        gr_vector_void_star &output_items)
+    {
+      work_stats::timer timer(*this, noutput_items);
+      denormal_guard guard;
+      const float *in = (const float *) input_items[0];
+      float *out = (float *) output_items[0];
+
+      // Parameter snapshot for this buffer
+      bypass::fade fade;
+      const bypass::state_t state = d_bypass.snapshot(noutput_items, fade);
+      if (state == bypass::ACTIVE || (state == bypass::BYPASSED && !d_ringing)) {
+        d_cur_ring_out = d_ring_out.get();
+      }
+      const bool ring_out = d_cur_ring_out;
+      if (state == bypass::BYPASSED && !(ring_out && d_ringing)) {
+        d_ringing = false;
+        bypass::copy(in, out, noutput_items);
+        return noutput_items;
+      }
+      d_ringing = true;
+      smoothed_param<double>::ramp wet_gamma;
+      d_wet_gamma.snapshot(noutput_items, wet_gamma);
+
+      if (state == bypass::ACTIVE || !ring_out) {
+        // Compute the wet signal in place in the output buffer
+        d_convolver->process(in, out, noutput_items);
+        for (int i = 0; i < noutput_items; i++) {
+          const double g = wet_gamma.at(i);
+          out[i] = (g * out[i]) + ((1.0 - g) * in[i]);
+        }
+        if (state == bypass::FADING) {
+          fade.crossfade(in, out, noutput_items);
+        }
+      } else {
+        // Ringing out: the input of the convolution fades instead of
+        // its output, and the dry signal stays at unity
+        float faded[bypass::CHUNK_SIZE];
+        float wet[bypass::CHUNK_SIZE];
+        float peak = 0.0f;
+        for (int offset = 0; offset < noutput_items; offset += bypass::CHUNK_SIZE) {
+          const int nitems = std::min<int>(bypass::CHUNK_SIZE, noutput_items - offset);
+          fade.fade_input(in + offset, faded, nitems, offset);
+          d_convolver->process(faded, wet, nitems);
+          for (int i = 0; i < nitems; i++) {
+            const double g = wet_gamma.at(offset + i);
+            peak = std::max(peak, std::abs(wet[i]));
+            out[offset + i] = (g * (wet[i] - faded[i])) + in[offset + i];
+          }
+        }
+        if (state == bypass::BYPASSED && bypass::tail_done(peak)) {
+          d_ringing = false;
+        }
+      }
+
+      return noutput_items;
+    }
+
+  } /* namespace guitar */
+} /* namespace gr */
@@ -0,0 +1,68 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2018 Ashish Chaudhari.
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GUITAR_CONVOLUTION_REVERB_IMPL_H
+#define INCLUDED_GUITAR_CONVOLUTION_REVERB_IMPL_H
+
+#include <guitar/convolution_reverb.h>
+#include "bypass.h"
+#include "param.h"
+#include "partitioned_convolver.h"
+#include "work_stats.h"
+
+namespace gr {
+  namespace guitar {
+
+    class convolution_reverb_impl : public convolution_reverb, public work_stats
+    {
+     private:
+      // Parameters
+      bypass d_bypass;
+      smoothed_param<double> d_wet_gamma;
+      param<bool> d_ring_out;
+
+      // Filter
+      partitioned_convolver* d_convolver;
+      // Set while the tail is still audible
+      bool d_ringing;
+      // The ring_out in effect. Only follows d_ring_out while no fade
+      // or tail is under way, so a change can not cut a tail short.
+      bool d_cur_ring_out;
+
+     public:
+      convolution_reverb_impl(bool enabled, double samp_rate, const std::string& ir_file,
+          int partition_size, double wet_gamma, bool ring_out);
+      ~convolution_reverb_impl();
+
+      // Where all the action really happens
+      int work(int noutput_items,
+         gr_vector_const_void_star &input_items,
+         gr_vector_void_star &output_items);
+      void setup_rpc();
+
+      void set_enabled(bool enabled);
+      void set_wet_gamma(double wet_gamma);
+      void set_ring_out(bool ring_out);
+    };
+
+  } // namespace guitar
+} // namespace gr
+
+#endif /* INCLUDED_GUITAR_CONVOLUTION_REVERB_IMPL_H */
@@ -0,0 +1,145 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_DENORMAL_H
+#define INCLUDED_DENORMAL_H
+
+#include <boost/noncopyable.hpp>
+#include <stdint.h>
+
+#if defined(__SSE__) || defined(__x86_64__)
+#include <xmmintrin.h>
+#define GUITAR_HAVE_FTZ 1
+#elif defined(__aarch64__) || (defined(__arm__) && defined(__VFP_FP__) && !defined(__SOFTFP__))
+#define GUITAR_HAVE_FTZ 1
+#endif
+
+// Where the guard can not flush subnormals to zero, the recursive
+// filters keep their state out of the subnormal range with an offset
+#if !defined(GUITAR_HAVE_FTZ) && !defined(GUITAR_DENORMAL_OFFSET)
+#define GUITAR_DENORMAL_OFFSET 1
+#endif
+
+namespace gr {
+  namespace guitar {
+
+  /*!
+   * \brief flushes subnormal floats to zero while in scope
+   *
+   * The state of a recursive filter decays towards zero once its
+   * input goes silent, and arithmetic on subnormal values is 10-100x
+   * slower on most CPUs. Every work() holds a guard so that a block
+   * costs the same on a decaying tail as on a loud signal. The guard
+   * sets flush-to-zero (and denormals-are-zero on x86-64) in the
+   * floating point control register of the calling thread and puts
+   * back the previous mode when it goes out of scope, so it never
+   * leaks into other blocks sharing the thread.
+   *
+   * On platforms without such a mode the guard does nothing, and
+   * GUITAR_DENORMAL_OFFSET is defined instead.
+   */
+  class denormal_guard : boost::noncopyable
+  {
+  public:
+#if defined(__SSE__) || defined(__x86_64__)
+    denormal_guard(): d_saved(_mm_getcsr())
+    {
+      _mm_setcsr(d_saved | FLAGS);
+    }
+
+    ~denormal_guard()
+    {
+      _mm_setcsr(d_saved);
+    }
+
+  private:
+#if defined(__x86_64__)
+    static const unsigned FLAGS = 0x8040;    // FTZ | DAZ
+#else
+    static const unsigned FLAGS = 0x8000;    // FTZ, DAZ is missing on early SSE parts
+#endif
+    const unsigned d_saved;
+#elif defined(__aarch64__)
+    denormal_guard()
+    {
+      uint64_t fpcr;
+      __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+      d_saved = fpcr;
+      fpcr |= (1 << 24);    // FZ
+      __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+    }
+
+    ~denormal_guard()
+    {
+      __asm__ __volatile__("msr fpcr, %0" : : "r"(d_saved));
+    }
+
+  private:
+    uint64_t d_saved;
+#elif defined(GUITAR_HAVE_FTZ)
+    denormal_guard()
+    {
+      uint32_t fpscr;
+      __asm__ __volatile__("vmrs %0, fpscr" : "=r"(fpscr));
+      d_saved = fpscr;
+      fpscr |= (1 << 24);   // FZ
+      __asm__ __volatile__("vmsr fpscr, %0" : : "r"(fpscr));
+    }
+
+    ~denormal_guard()
+    {
+      __asm__ __volatile__("vmsr fpscr, %0" : : "r"(d_saved));
+    }
+
+  private:
+    uint32_t d_saved;
+#else
+    denormal_guard() {}
+#endif
+  };
+
+  /*!
+   * \brief a tiny offset to add to the state of a recursive filter
+   * once per buffer
+   *
+   * Only used with GUITAR_DENORMAL_OFFSET. The offset sits far below
+   * anything audible (-360 dB) but far above the subnormal range of a
+   * float. Its sign flips on every buffer, so that filters that block
+   * DC still see it.
+   */
+  class denormal_offset
+  {
+  public:
+    denormal_offset(): d_value(1e-18f) {}
+
+    float next()
+    {
+      d_value = -d_value;
+      return d_value;
+    }
+
+  private:
+    float d_value;
+  };
+
+  } /* namespace guitar */
+} /* namespace gr */
+
+#endif /* INCLUDED_DENORMAL_H */
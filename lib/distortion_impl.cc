@@ -23,10 +23,10 @@
 #endif
 
 #include <gnuradio/io_signature.h>
+#include <stdexcept>
+#include "denormal.h"
 #include "distortion_impl.h"
 
-#define PI  3.14159265358979323846
-
 namespace gr {
   namespace guitar {
 
@@ -44,10 +44,11 @@ namespace gr {
       : gr::sync_block("distortion",
         gr::io_signature::make(1, 1, sizeof(float)),
         gr::io_signature::make(1, 1, sizeof(float))),
-        d_enabled(enabled), d_boost(boost), d_wet_gamma(wet_gamma),
-        d_dist_func(NULL)
+        d_bypass(enabled), d_boost(boost), d_wet_gamma(wet_gamma),
+        d_ctrl_shaper(dist_func, boost), d_shaper(NULL)
     {
-      set_dist_func(dist_func);
+      setup_stats_port(this);
+      d_shaper = new waveshaper(d_ctrl_shaper);
     }
 
     /*
@@ -55,59 +56,59 @@ namespace gr {
      */
     distortion_impl::~distortion_impl()
     {
+      delete d_shaper;
     }
 
     void
     distortion_impl::set_enabled(bool enabled)
     {
-      d_enabled = enabled;
+      d_bypass.set_enabled(enabled);
     }
 
     void
     distortion_impl::set_dist_func(std::string dist_func)
     {
-      if (dist_func == "L") {
-        d_dist_func = [](const float& x){
-          return x;
-        };
-      } else if (dist_func == "Q") {
-        d_dist_func = [](const float& x) -> float {
-          return (1.0 - (1.0 - x) * (1.0 - x));
-        };
-      } else if (dist_func == "E") {
-        d_dist_func = [](const float& x) -> float {
-          return ((1.0 - exp(-1.0 * x)) / exp(-0.5));
-        };
-      } else if (dist_func == "I") {
-        d_dist_func = [](const float& x) -> float {
-          return ((2 * x) / (1 + x));
-        };
-      } else if (dist_func == "S") {
-        d_dist_func = [](const float& x) -> float {
-          return sin((PI / 2) * x);
-        };
-      } else {
+      // Validate and build the table here, so that work() only swaps
+      // in the finished waveshaper
+      if (!waveshaper::valid_dist_func(dist_func)) {
         throw std::invalid_argument("distortion: Distortion function not supported.");
       }
+      d_ctrl_shaper.set_dist_func(dist_func);
+      d_new_shapers.publish(new waveshaper(d_ctrl_shaper));
     }
 
     float
     distortion_impl::wrap_and_clip(float x)
     {
-        const float sign = (x >= 0.0) ? 1.0 : -1.0;
-        const float dist_x = (abs(x) * d_boost < 1.0) ? d_dist_func(abs(x) * d_boost) : 1.0;
-        return (sign * std::min<float>(dist_x, 1.0));
+      return d_ctrl_shaper.shape(x);
     }
 
     void
     distortion_impl::set_boost(double boost)
     {
-      d_boost = boost;
+      d_boost.set(boost);
+      d_ctrl_shaper.set_boost(boost);
     }
 
     void distortion_impl::set_wet_gamma(double wet_gamma)
     {
-      d_wet_gamma = wet_gamma;
+      d_wet_gamma.set(wet_gamma);
+    }
+
+    void
+    distortion_impl::_swap_shapers()
+    {
+      waveshaper* shaper = d_new_shapers.take();
+      if (shaper != NULL) {
+        d_new_shapers.retire(d_shaper);
+        d_shaper = shaper;
+      }
+    }
+
+    void
+    distortion_impl::setup_rpc()
+    {
+      setup_stats_rpc(this);
     }
 
     int
@@ -115,13 +116,24 @@ namespace gr {
         gr_vector_const_void_star &input_items,
         gr_vector_void_star &output_items)
     {
+      work_stats::timer timer(*this, noutput_items);
+      denormal_guard guard;
       const float *in = (const float *) input_items[0];
       float *out = (float *) output_items[0];
 
-      for (int i = 0; i < noutput_items; i++) {
-        const float dry = in[i];
-        const float sign = (dry >= 0.0) ? 1.0 : -1.0;
-        out[i] = d_enabled ? (d_wet_gamma*wrap_and_clip(dry) + (1-d_wet_gamma)*dry) : dry;
+      bypass::fade fade;
+      const bypass::state_t state = d_bypass.snapshot(noutput_items, fade);
+      if (state == bypass::BYPASSED) {
+        bypass::copy(in, out, noutput_items);
+        return noutput_items;
+      }
+
+      _swap_shapers();
+      // The boost only scales the table index, so it is set here
+      d_shaper->set_boost(d_boost.get());
+      d_shaper->process(in, out, noutput_items, true, d_wet_gamma.get());
+      if (state == bypass::FADING) {
+        fade.crossfade(in, out, noutput_items);
       }
 
       return noutput_items;
@@ -22,24 +22,38 @@
 #define INCLUDED_GUITAR_DISTORTION_IMPL_H
 
 #include <guitar/distortion.h>
-#include <map>
+#include "bypass.h"
+#include "handoff.h"
+#include "param.h"
+#include "waveshaper.h"
+#include "work_stats.h"
 
 namespace gr {
   namespace guitar {
 
-    class distortion_impl : public distortion
+    class distortion_impl : public distortion, public work_stats
     {
      private:
-      bool d_enabled;
-      double d_boost;
-      double d_wet_gamma;
+      bypass d_bypass;
+      param<double> d_boost;
+      param<double> d_wet_gamma;
 
-      float(*d_dist_func)(const float&);
+      // The curve and boost last set. Owned by the setters, which build
+      // its table and hand work() a copy. wrap_and_clip() reads it.
+      waveshaper d_ctrl_shaper;
+      handoff<waveshaper> d_new_shapers;
+
+      // Owned by work()
+      waveshaper* d_shaper;
+
+      void _swap_shapers();
 
      public:
       distortion_impl(bool enabled, std::string dist_func, double boost, double wet_gamma);
       ~distortion_impl();
 
+      //! Distort a single sample with the curve and boost last set.
+      //! Call it from the thread that calls the setters.
       float wrap_and_clip(float x);
 
       void set_enabled(bool enabled);
@@ -51,6 +65,7 @@ namespace gr {
       int work(int noutput_items,
          gr_vector_const_void_star &input_items,
          gr_vector_void_star &output_items);
+      void setup_rpc();
     };
 
   } // namespace guitar
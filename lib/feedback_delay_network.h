@@ -0,0 +1,241 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_FEEDBACK_DELAY_NETWORK_H
+#define INCLUDED_FEEDBACK_DELAY_NETWORK_H
+
+#include <boost/noncopyable.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "simd.h"
+
+namespace gr {
+  namespace guitar {
+
+  /*!
+   * \brief class template for a feedback delay network of N delay lines
+   *
+   * Every sample, the outputs s_i of the N delay lines are attenuated
+   * by their gains g_i, mixed by the orthogonal Hadamard matrix
+   * H_N / sqrt(N) and written back into the lines together with the
+   * input. The output is the sum of the line outputs, scaled so that
+   * the level does not depend on N. N must be a power of two.
+   *
+   * Like comb_bank, any run of up to the shortest delay only reads
+   * history written before the run started. filter_n() processes such
+   * runs one line at a time: the attenuation, the fast Walsh-Hadamard
+   * transform (N log2 N additions per sample) and the write back are
+   * all loops over contiguous samples, so they vectorize across time
+   * instead of across the N lines. On x86 an AVX build of the same
+   * kernel is selected at runtime when the CPU supports it.
+   *
+   * The delay lines may be carved out of caller-provided memory of at
+   * least storage_size() bytes.
+   */
+  template<class state_type, size_t N>
+  class feedback_delay_network : boost::noncopyable
+  {
+  public:
+    /*!
+     * \brief construct a network that supports delays up to \p max_delay
+     *
+     * All lines start out with delay 1 and zero gain.
+     *
+     * \param storage memory of at least storage_size(max_delay) bytes
+     *        for the delay lines, or NULL to allocate internally.
+     */
+    feedback_delay_network(size_t max_delay, void* storage = NULL):
+      d_mask(_next_pow2(std::max<size_t>(max_delay, 1)) - 1),
+      d_wr_idx(0), d_min_delay(1),
+      d_out_scale(2.0 / std::sqrt(static_cast<double>(N)))
+    {
+      if (storage == NULL) {
+        d_owned_storage.resize(storage_size(max_delay));
+        storage = &d_owned_storage[0];
+      }
+      d_lines = static_cast<state_type*>(storage);
+      for (size_t l = 0; l < N; l++) {
+        set_line(l, 1, 0.0);
+      }
+      d_kernel = &feedback_delay_network::_filter_n_generic;
+#if defined(GUITAR_HAVE_AVX_DISPATCH)
+      if (__builtin_cpu_supports("avx")) {
+        d_kernel = &feedback_delay_network::_filter_n_avx;
+      }
+#endif
+      reset();
+    }
+
+    //! bytes of delay line storage needed by a network with \p max_delay
+    static size_t storage_size(size_t max_delay)
+    {
+      const size_t buff_len = _next_pow2(std::max<size_t>(max_delay, 1));
+      return _align(buff_len * N * sizeof(state_type));
+    }
+
+    /*!
+     * \brief install the delay and gain of \p line.
+     *
+     * \p delay is clamped to [1, max_delay].
+     */
+    void set_line(size_t line, size_t delay, state_type gain)
+    {
+      d_delay[line] = std::min(std::max<size_t>(delay, 1), d_mask + 1);
+      // The 1/sqrt(N) of the mixing matrix is folded into the gains
+      d_gain[line] = gain / std::sqrt(static_cast<state_type>(N));
+      d_min_delay = *std::min_element(d_delay, d_delay + N);
+    }
+
+    /*!
+     * \brief compute \p n output values.
+     *
+     * \p input and \p output may point to the same buffer.
+     */
+    void filter_n(const float* input, float* output, size_t n)
+    {
+      (this->*d_kernel)(input, output, n);
+    }
+
+    //! reset state to zero
+    void reset()
+    {
+      std::fill(d_lines, d_lines + ((d_mask + 1) * N), state_type(0.0));
+      d_wr_idx = 0;
+    }
+
+  private:
+    typedef void (feedback_delay_network::*kernel_t)(const float*, float*, size_t);
+
+    static const size_t RUN_SIZE = 64;
+
+    static size_t _next_pow2(size_t n)
+    {
+      size_t p = 1;
+      while (p < n) p <<= 1;
+      return p;
+    }
+
+    // Round up to a cache line so that every delay line is aligned
+    static size_t _align(size_t n)
+    {
+      return (n + 63) & ~static_cast<size_t>(63);
+    }
+
+    // Shared body of the kernels. Always inlined so that each caller
+    // is compiled for its own target instruction set.
+#if defined(GUITAR_HAVE_AVX_DISPATCH)
+    inline __attribute__((always_inline))
+#endif
+    void _filter_n_body(const float* input, float* output, size_t n)
+    {
+      const size_t buff_len = d_mask + 1;
+      state_type s[N][RUN_SIZE];
+      state_type x[RUN_SIZE];
+      state_type y[RUN_SIZE];
+
+      while (n > 0) {
+        const size_t run = std::min(std::min(n, d_min_delay), static_cast<size_t>(RUN_SIZE));
+
+        for (size_t k = 0; k < run; k++) {
+          x[k] = input[k];
+          y[k] = 0.0;
+        }
+
+        // Read the line outputs and sum them
+        for (size_t l = 0; l < N; l++) {
+          const state_type* line = &d_lines[l * buff_len];
+          const size_t rd_idx = (d_wr_idx - d_delay[l]) & d_mask;
+          const size_t first = std::min(run, buff_len - rd_idx);
+          std::copy(line + rd_idx, line + rd_idx + first, s[l]);
+          std::copy(line, line + (run - first), s[l] + first);
+          const state_type gain = d_gain[l];
+          for (size_t k = 0; k < run; k++) {
+            y[k] += s[l][k];
+            s[l][k] *= gain;
+          }
+        }
+
+        // Fast Walsh-Hadamard transform across the lines
+        for (size_t h = 1; h < N; h <<= 1) {
+          for (size_t i = 0; i < N; i += 2 * h) {
+            for (size_t j = i; j < i + h; j++) {
+              state_type* a = s[j];
+              state_type* b = s[j + h];
+              for (size_t k = 0; k < run; k++) {
+                const state_type sum = a[k] + b[k];
+                b[k] = a[k] - b[k];
+                a[k] = sum;
+              }
+            }
+          }
+        }
+
+        // Feed back together with the input
+        const size_t first = std::min(run, buff_len - d_wr_idx);
+        for (size_t l = 0; l < N; l++) {
+          state_type* line = &d_lines[l * buff_len];
+          for (size_t k = 0; k < first; k++) {
+            line[d_wr_idx + k] = s[l][k] + x[k];
+          }
+          for (size_t k = first; k < run; k++) {
+            line[k - first] = s[l][k] + x[k];
+          }
+        }
+
+        for (size_t k = 0; k < run; k++) {
+          output[k] = static_cast<float>(y[k] * d_out_scale);
+        }
+
+        d_wr_idx = (d_wr_idx + run) & d_mask;
+        input += run;
+        output += run;
+        n -= run;
+      }
+    }
+
+    void _filter_n_generic(const float* input, float* output, size_t n)
+    {
+      _filter_n_body(input, output, n);
+    }
+
+#if defined(GUITAR_HAVE_AVX_DISPATCH)
+    __attribute__((target("avx")))
+    void _filter_n_avx(const float* input, float* output, size_t n)
+    {
+      _filter_n_body(input, output, n);
+    }
+#endif
+
+    const size_t d_mask;
+    std::vector<char> d_owned_storage;
+    state_type* d_lines;        // Line l starts at l * (max_delay rounded up)
+    size_t      d_wr_idx;
+    size_t      d_delay[N];
+    size_t      d_min_delay;
+    state_type  d_gain[N];
+    const state_type d_out_scale;
+    kernel_t    d_kernel;
+  };
+
+  } /* namespace guitar */
+} /* namespace gr */
+
+#endif /* INCLUDED_FEEDBACK_DELAY_NETWORK_H */
@@ -23,36 +23,43 @@
 #endif
 
 #include <gnuradio/io_signature.h>
+#include <stdexcept>
+#include "denormal.h"
 #include "flanger_impl.h"
 
-#define PI  3.14159265358979323846
-
 namespace gr {
   namespace guitar {
 
     flanger::sptr
-    flanger::make(bool enabled, double samp_rate, double max_delay, double lfo_freq, double wet_gamma)
+    flanger::make(bool enabled, double samp_rate, double max_delay, double lfo_freq, double wet_gamma,
+        std::string interp)
     {
       return gnuradio::get_initial_sptr
-        (new flanger_impl(enabled, samp_rate, max_delay, lfo_freq, wet_gamma));
+        (new flanger_impl(enabled, samp_rate, max_delay, lfo_freq, wet_gamma, interp));
     }
 
     /*
      * The private constructor
      */
-    flanger_impl::flanger_impl(bool enabled, double samp_rate, double max_delay, double lfo_freq, double wet_gamma)
+    flanger_impl::flanger_impl(bool enabled, double samp_rate, double max_delay, double lfo_freq, double wet_gamma,
+        std::string interp)
       : gr::sync_block("flanger",
         gr::io_signature::make(1, 1, sizeof(float)),
         gr::io_signature::make(1, 1, sizeof(float))),
-        d_samp_rate(samp_rate), d_enabled(enabled),
-        d_max_delay(max_delay), d_lfo_freq(lfo_freq), d_wet_gamma(wet_gamma),
-        d_lfo_phase(0.0), d_delay_line(NULL)
+        d_samp_rate(samp_rate), d_max_delay(max_delay),
+        d_bypass(enabled), d_lfo_freq(lfo_freq), d_wet_gamma(wet_gamma),
+        d_interp(INTERP_LINEAR),
+        d_lfo(samp_rate, lfo_freq, lfo::SINE, -0.25), d_wr_idx(0)
     {
-      const size_t delay_line_len = static_cast<size_t>(d_samp_rate * d_max_delay);
-      d_delay_line = new boost::circular_buffer<float>(delay_line_len);
-      for (size_t i = 0; i < d_delay_line->capacity(); i++) {
-        d_delay_line->push_back(0.0);
-      }
+      setup_stats_port(this);
+      set_interp(interp);
+
+      d_delay_len = std::max<size_t>(static_cast<size_t>(d_samp_rate * d_max_delay), 1);
+      // Room for the current sample and the taps of the cubic interpolator
+      size_t buff_len = 1;
+      while (buff_len < (d_delay_len + 3)) buff_len <<= 1;
+      d_mask = buff_len - 1;
+      d_delay_line.assign(buff_len, 0.0);
     }
 
     /*
@@ -65,30 +72,94 @@ namespace gr {
     double
     flanger_impl::_gen_lfo_next()
     {
-      d_lfo_phase += (2.0 * PI) / d_samp_rate;
-      double lfo_val = 0.5 + (-0.5 * cos(d_lfo_phase * d_lfo_freq));
-      if (d_lfo_phase > (2 * PI) / d_lfo_freq) {
-        d_lfo_phase = 0;
-      }
-      return lfo_val;
+      // 0.5 - 0.5*cos(), i.e. the sweep starts at the longest delay
+      return 0.5 + (0.5 * d_lfo.next());
     }
 
     void
     flanger_impl::set_enabled(bool enabled)
     {
-      d_enabled = enabled;
+      d_bypass.set_enabled(enabled);
     }
 
     void
     flanger_impl::set_lfo_freq(double lfo_freq)
     {
-      d_lfo_freq = lfo_freq;
+      d_lfo_freq.set(lfo_freq);
     }
 
     void
     flanger_impl::set_wet_gamma(double wet_gamma)
     {
-      d_wet_gamma = wet_gamma;
+      d_wet_gamma.set(wet_gamma);
+    }
+
+    void
+    flanger_impl::set_interp(std::string interp)
+    {
+      if (interp == "N") {
+        d_interp.set(INTERP_NONE);
+      } else if (interp == "L") {
+        d_interp.set(INTERP_LINEAR);
+      } else if (interp == "C") {
+        d_interp.set(INTERP_CUBIC);
+      } else {
+        throw std::invalid_argument("flanger: Interpolation mode not supported.");
+      }
+    }
+
+    template<flanger_impl::interp_t interp>
+    void
+    flanger_impl::_process(const float* in, float* out, int nitems,
+        const smoothed_param<double>::ramp& wet_gamma)
+    {
+      const float* delay_line = &d_delay_line[0];
+      const double sweep = d_delay_len - 1;
+      size_t wr_idx = d_wr_idx;
+
+      for (int i = 0; i < nitems; i++) {
+        const float dry = in[i];
+        d_delay_line[wr_idx] = dry;
+
+        // Delay in samples, from delay_len (LFO at 0) down to 1 (LFO at 1)
+        const double pos = _gen_lfo_next() * sweep;
+        const size_t ipos = static_cast<size_t>(pos);
+        const size_t delay = d_delay_len - ipos;
+        // x(n-k) is at (wr_idx - k) & d_mask
+        const float x0 = delay_line[(wr_idx - delay) & d_mask];
+        float wet;
+        if (interp == INTERP_NONE) {
+          wet = x0;
+        } else {
+          // Fraction of a sample by which the delay is shorter than
+          // delay, i.e. towards x(n-delay+1)
+          const float t = pos - ipos;
+          const float x1 = delay_line[(wr_idx - delay + 1) & d_mask];
+          if (interp == INTERP_LINEAR) {
+            wet = x0 + (t * (x1 - x0));
+          } else {
+            const float xm1 = delay_line[(wr_idx - delay - 1) & d_mask];
+            const float x2 = delay_line[(wr_idx - delay + 2) & d_mask];
+            // Third order Lagrange through x(-1), x0, x1, x2 at t
+            const float cm1 = -t * (t - 1.0f) * (t - 2.0f) / 6.0f;
+            const float c0  = (t + 1.0f) * (t - 1.0f) * (t - 2.0f) / 2.0f;
+            const float c1  = -(t + 1.0f) * t * (t - 2.0f) / 2.0f;
+            const float c2  = (t + 1.0f) * t * (t - 1.0f) / 6.0f;
+            wet = (cm1 * xm1) + (c0 * x0) + (c1 * x1) + (c2 * x2);
+          }
+        }
+        const double g = wet_gamma.at(i);
+        out[i] = (g * wet) + ((1.0 - g) * dry);
+
+        wr_idx = (wr_idx + 1) & d_mask;
+      }
+      d_wr_idx = wr_idx;
+    }
+
+    void
+    flanger_impl::setup_rpc()
+    {
+      setup_stats_rpc(this);
     }
 
     int
@@ -96,18 +167,36 @@ namespace gr {
         gr_vector_const_void_star &input_items,
         gr_vector_void_star &output_items)
     {
+      work_stats::timer timer(*this, noutput_items);
+      denormal_guard guard;
       const float *in = (const float *) input_items[0];
       float *out = (float *) output_items[0];
-      float *dbg = (float *) output_items[1];
 
-      for (int i = 0; i < noutput_items; i++) {
-        const size_t curr_delay = static_cast<size_t>(
-           _gen_lfo_next() * (d_delay_line->capacity()-1));
-        const float dry = in[i];
-        const float wet = (*d_delay_line)[curr_delay];
-        out[i] = (d_wet_gamma * wet) + ((1.0 - d_wet_gamma) * dry);
+      bypass::fade fade;
+      const bypass::state_t state = d_bypass.snapshot(noutput_items, fade);
+      if (state == bypass::BYPASSED) {
+        bypass::copy(in, out, noutput_items);
+        return noutput_items;
+      }
 
-        d_delay_line->push_back(dry);
+      // Parameter snapshot for this buffer
+      d_lfo.set_freq(d_lfo_freq.get());
+      smoothed_param<double>::ramp wet_gamma;
+      d_wet_gamma.snapshot(noutput_items, wet_gamma);
+
+      switch (d_interp.get()) {
+        case INTERP_NONE:
+          _process<INTERP_NONE>(in, out, noutput_items, wet_gamma);
+          break;
+        case INTERP_LINEAR:
+          _process<INTERP_LINEAR>(in, out, noutput_items, wet_gamma);
+          break;
+        default:
+          _process<INTERP_CUBIC>(in, out, noutput_items, wet_gamma);
+          break;
+      }
+      if (state == bypass::FADING) {
+        fade.crossfade(in, out, noutput_items);
       }
 
       return noutput_items;
@@ -115,4 +204,3 @@ namespace gr {
 
   } /* namespace guitar */
 } /* namespace gr */
-
@@ -22,41 +22,63 @@
 #define INCLUDED_GUITAR_FLANGER_IMPL_H
 
 #include <guitar/flanger.h>
-#include <boost/circular_buffer.hpp>
+#include <vector>
+#include "bypass.h"
+#include "lfo.h"
+#include "param.h"
+#include "work_stats.h"
 
 namespace gr {
   namespace guitar {
 
-    class flanger_impl : public flanger
+    //  The flanger mixes the input with a copy of itself delayed by
+    //  between 1 and delay_len samples, where the delay is swept by
+    //  an LFO. The delay line is a flat power-of-two array indexed
+    //  with a mask, and the delayed signal is read at the fractional
+    //  delay using the selected interpolation mode.
+    class flanger_impl : public flanger, public work_stats
     {
      private:
+      enum interp_t { INTERP_NONE, INTERP_LINEAR, INTERP_CUBIC };
+
       const double d_samp_rate;
-      double d_enabled;
-      double d_max_delay;
-      double d_lfo_freq;
-      double d_wet_gamma;
+      const double d_max_delay;
+      bypass d_bypass;
+      param<double> d_lfo_freq;
+      smoothed_param<double> d_wet_gamma;
+      param<interp_t> d_interp;
 
-      double d_lfo_phase;
-      boost::circular_buffer<float>* d_delay_line;
+      // Owned by work()
+      lfo d_lfo;
+      size_t d_delay_len;
+      size_t d_mask;
+      size_t d_wr_idx;
+      std::vector<float> d_delay_line;
 
       double _gen_lfo_next();
 
+      template<interp_t interp>
+      void _process(const float* in, float* out, int nitems,
+          const smoothed_param<double>::ramp& wet_gamma);
+
      public:
-      flanger_impl(bool enabled, double samp_rate, double max_delay, double lfo_freq, double wet_gamma);
+      flanger_impl(bool enabled, double samp_rate, double max_delay, double lfo_freq, double wet_gamma,
+          std::string interp);
       ~flanger_impl();
 
       // Where all the action really happens
       int work(int noutput_items,
          gr_vector_const_void_star &input_items,
          gr_vector_void_star &output_items);
+      void setup_rpc();
 
       void set_enabled(bool enabled);
       void set_lfo_freq(double lfo_freq);
       void set_wet_gamma(double wet_gamma);
+      void set_interp(std::string interp);
 };
 
   } // namespace guitar
 } // namespace gr
 
 #endif /* INCLUDED_GUITAR_FLANGER_IMPL_H */
-
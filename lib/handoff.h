@@ -0,0 +1,133 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_HANDOFF_H
+#define INCLUDED_HANDOFF_H
+
+#include <boost/noncopyable.hpp>
+#include <atomic>
+#include <cstddef>
+
+namespace gr {
+  namespace guitar {
+
+  /*!
+   * \brief lock-free hand-over of heap objects from a writer thread to
+   * a reader thread that must not allocate or free memory
+   *
+   * The writer builds an object and publish()es it. The reader take()s
+   * it with a single atomic exchange, and once it is done with the
+   * object it replaced, it retire()s that one into a small set of
+   * slots. The writer deletes retired objects on its next publish() or
+   * collect(), and the destructor deletes whatever is left. An object
+   * published while an earlier one is still pending replaces it.
+   * Instead of letting retired objects be deleted, the writer can
+   * reclaim() them and reuse them for the next publish().
+   *
+   * The reader must retire exactly one object per object it takes,
+   * before taking the next one. take() returns NULL while no retire
+   * slot is free, so a retire() always finds room.
+   */
+  template<class T>
+  class handoff : boost::noncopyable
+  {
+  public:
+    handoff(): d_pending(NULL)
+    {
+      for (size_t i = 0; i < NUM_SLOTS; i++) {
+        d_retired[i].store(NULL, std::memory_order_relaxed);
+      }
+    }
+
+    ~handoff()
+    {
+      collect();
+      delete d_pending.load(std::memory_order_acquire);
+    }
+
+    //! hand \p obj over to the reader. Writer thread only.
+    void publish(T* obj)
+    {
+      collect();
+      delete d_pending.exchange(obj, std::memory_order_acq_rel);
+    }
+
+    //! delete the objects retired by the reader. Writer thread only.
+    void collect()
+    {
+      for (size_t i = 0; i < NUM_SLOTS; i++) {
+        if (d_retired[i].load(std::memory_order_relaxed) != NULL) {
+          delete d_retired[i].exchange(NULL, std::memory_order_acquire);
+        }
+      }
+    }
+
+    //! a retired object for reuse, or NULL. Writer thread only.
+    T* reclaim()
+    {
+      for (size_t i = 0; i < NUM_SLOTS; i++) {
+        if (d_retired[i].load(std::memory_order_relaxed) != NULL) {
+          return d_retired[i].exchange(NULL, std::memory_order_acquire);
+        }
+      }
+      return NULL;
+    }
+
+    //! the latest published object, or NULL. Reader thread only.
+    T* take()
+    {
+      if (d_pending.load(std::memory_order_relaxed) == NULL || !_slot_free()) {
+        return NULL;
+      }
+      return d_pending.exchange(NULL, std::memory_order_acq_rel);
+    }
+
+    //! pass \p obj back to the writer for deletion. Reader thread only.
+    void retire(T* obj)
+    {
+      for (size_t i = 0; i < NUM_SLOTS; i++) {
+        T* expected = NULL;
+        if (d_retired[i].compare_exchange_strong(expected, obj, std::memory_order_release)) {
+          return;
+        }
+      }
+    }
+
+  private:
+    static const size_t NUM_SLOTS = 4;
+
+    bool _slot_free() const
+    {
+      for (size_t i = 0; i < NUM_SLOTS; i++) {
+        if (d_retired[i].load(std::memory_order_relaxed) == NULL) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    std::atomic<T*> d_pending;
+    std::atomic<T*> d_retired[NUM_SLOTS];
+  };
+
+  } /* namespace guitar */
+} /* namespace gr */
+
+#endif /* INCLUDED_HANDOFF_H */
@@ -41,10 +41,10 @@ namespace gr {
     iir_decimator_impl::iir_decimator_impl(int decimation, const std::vector<double> &fftaps, const std::vector<double> &fbtaps)
       : gr::sync_decimator("iir_decimator",
         gr::io_signature::make(1, 1, sizeof(float)),
-        gr::io_signature::make(1, 1, sizeof(float)), decimation),
-        d_updated(false)
+        gr::io_signature::make(1, 1, sizeof(float)), decimation)
     {
-      d_iir = new filter::kernel::iir_filter<float,float,double,double>(fftaps, fbtaps, false);
+      setup_stats_port(this);
+      d_iir = new polyphase_iir_filter<float,float,double>(decimation, fftaps, fbtaps);
     }
 
     /*
@@ -59,9 +59,16 @@ namespace gr {
     iir_decimator_impl::set_taps(const std::vector<double> &fftaps,
           const std::vector<double> &fbtaps)
     {
-      d_new_fftaps = fftaps;
-      d_new_fbtaps = fbtaps;
-      d_updated = true;
+      taps_update update;
+      update.fftaps = fftaps;
+      update.fbtaps = fbtaps;
+      d_new_taps.write(update);
+    }
+
+    void
+    iir_decimator_impl::setup_rpc()
+    {
+      setup_stats_rpc(this);
     }
 
     int
@@ -69,25 +76,21 @@ namespace gr {
         gr_vector_const_void_star &input_items,
         gr_vector_void_star &output_items)
     {
+      work_stats::timer timer(*this, noutput_items);
+      denormal_guard guard;
       const float *in = (const float *) input_items[0];
       float *out = (float *) output_items[0];
 
-      if(d_updated) {
-        d_iir->set_taps(d_new_fftaps, d_new_fbtaps);
-        d_updated = false;
+      if (d_new_taps.read(d_taps)) {
+        d_iir->set_taps(d_taps.fftaps, d_taps.fbtaps);
       }
+#ifdef GUITAR_DENORMAL_OFFSET
+      d_iir->offset_state(d_denormal.next());
+#endif
 
-      int ninput_items = noutput_items * decimation();
-      int ndecim = decimation();
-
-      for (int i = 0; i < ninput_items; i++) {
-        // Filter even if we are discarding to ensure that
-        // the delay-lines have the correct values
-        float tmp = d_iir->filter(in[i]);
-        if (i % ndecim == 0) {
-          out[i/ndecim] = tmp;
-        }
-      }
+      // The recursion runs at the input rate, but the output
+      // is only computed for the samples that are kept
+      d_iir->decimate(in, out, noutput_items);
 
       return noutput_items;
     }
@@ -22,18 +22,28 @@
 #define INCLUDED_GUITAR_IIR_DECIMATOR_IMPL_H
 
 #include <guitar/iir_decimator.h>
-#include <gnuradio/filter/iir_filter.h>
+#include "denormal.h"
+#include "polyphase_iir_filter.h"
+#include "triple_buffer.h"
+#include "work_stats.h"
 
 namespace gr {
   namespace guitar {
 
-    class iir_decimator_impl : public iir_decimator
+    class iir_decimator_impl : public iir_decimator, public work_stats
     {
     private:
-      bool d_updated;
-      filter::kernel::iir_filter<float,float,double,double> *d_iir;
-      std::vector<double> d_new_fftaps;
-      std::vector<double> d_new_fbtaps;
+      struct taps_update {
+        std::vector<double> fftaps;
+        std::vector<double> fbtaps;
+      };
+
+      polyphase_iir_filter<float,float,double> *d_iir;
+#ifdef GUITAR_DENORMAL_OFFSET
+      denormal_offset d_denormal;
+#endif
+      triple_buffer<taps_update> d_new_taps;
+      taps_update d_taps;
 
      public:
       iir_decimator_impl(int decimation, const std::vector<double> &fftaps, const std::vector<double> &fbtaps);
@@ -45,6 +55,7 @@ namespace gr {
       int work(int noutput_items,
          gr_vector_const_void_star &input_items,
          gr_vector_void_star &output_items);
+      void setup_rpc();
     };
 
   } // namespace guitar
@@ -41,10 +41,10 @@ namespace gr {
     iir_interpolator_impl::iir_interpolator_impl(int interpolation, const std::vector<double> &fftaps, const std::vector<double> &fbtaps)
       : gr::sync_interpolator("iir_interpolator",
         gr::io_signature::make(1, 1, sizeof(float)),
-        gr::io_signature::make(1, 1, sizeof(float)), interpolation),
-        d_updated(false)
+        gr::io_signature::make(1, 1, sizeof(float)), interpolation)
     {
-      d_iir = new filter::kernel::iir_filter<float,float,double,double>(fftaps, fbtaps, false);
+      setup_stats_port(this);
+      d_iir = new polyphase_iir_filter<float,float,double>(interpolation, fftaps, fbtaps);
     }
 
     /*
@@ -59,9 +59,16 @@ namespace gr {
     iir_interpolator_impl::set_taps(const std::vector<double> &fftaps,
           const std::vector<double> &fbtaps)
     {
-      d_new_fftaps = fftaps;
-      d_new_fbtaps = fbtaps;
-      d_updated = true;
+      taps_update update;
+      update.fftaps = fftaps;
+      update.fbtaps = fbtaps;
+      d_new_taps.write(update);
+    }
+
+    void
+    iir_interpolator_impl::setup_rpc()
+    {
+      setup_stats_rpc(this);
     }
 
     int
@@ -69,22 +76,24 @@ namespace gr {
         gr_vector_const_void_star &input_items,
         gr_vector_void_star &output_items)
     {
+      work_stats::timer timer(*this, noutput_items);
+      denormal_guard guard;
       const float *in = (const float*)input_items[0];
       float *out = (float*)output_items[0];
 
-      if(d_updated) {
-        d_iir->set_taps(d_new_fftaps, d_new_fbtaps);
-        d_updated = false;
+      if (d_new_taps.read(d_taps)) {
+        d_iir->set_taps(d_taps.fftaps, d_taps.fbtaps);
       }
+#ifdef GUITAR_DENORMAL_OFFSET
+      d_iir->offset_state(d_denormal.next());
+#endif
 
       int ninput_items = noutput_items / interpolation();
-      int ninterp = interpolation();
 
-      for (int i = 0; i < (ninput_items * ninterp); i++) {
-        out[i] = d_iir->filter((i % ninterp == 0) ? in[i/ninterp] : 0.0);
-      }
+      // The polyphase filter skips the multiplies by the stuffed zeros
+      d_iir->interpolate(in, out, ninput_items);
 
-      return (ninput_items * ninterp);
+      return (ninput_items * interpolation());
     }
 
   } /* namespace guitar */
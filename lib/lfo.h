@@ -0,0 +1,144 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GUITAR_LFO_H
+#define INCLUDED_GUITAR_LFO_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace gr {
+  namespace guitar {
+
+  /*!
+   * \brief low frequency oscillator for modulation effects
+   *
+   * The phase is kept in cycles in [0, 1) and advanced by freq/samp_rate
+   * per sample, so it wraps without drift and a frequency change does
+   * not cause a jump. The sine shape is read from a shared wavetable
+   * with linear interpolation (max error about 5e-6), so producing a
+   * value never calls sin().
+   *
+   * All shapes are bipolar in [-1, 1] and follow sin(2*pi*phase): zero
+   * at phase 0, peak at phase 0.25 and trough at phase 0.75.
+   */
+  class lfo
+  {
+  public:
+    enum shape_t { SINE, TRIANGLE, SQUARE };
+
+    lfo(double samp_rate, double freq, shape_t shape = SINE, double phase = 0.0):
+      d_samp_rate(samp_rate), d_shape(shape), d_table(_sine_table())
+    {
+      set_freq(freq);
+      reset(phase);
+    }
+
+    void set_freq(double freq) { d_phase_inc = freq / d_samp_rate; }
+    void set_shape(shape_t shape) { d_shape = shape; }
+
+    //! restart at \p phase (in cycles)
+    void reset(double phase = 0.0)
+    {
+      d_phase = phase;
+      _wrap();
+    }
+
+    //! advance by one sample and return the new value
+    double next()
+    {
+      d_phase += d_phase_inc;
+      if (d_phase >= 1.0 || d_phase < 0.0) _wrap();
+      return _eval(d_phase);
+    }
+
+    //! advance by \p nsamps samples and return the new value
+    double advance(size_t nsamps)
+    {
+      d_phase += d_phase_inc * nsamps;
+      _wrap();
+      return _eval(d_phase);
+    }
+
+    //! equivalent to calling next() \p n times
+    template<class T>
+    void generate(T* out, size_t n)
+    {
+      for (size_t i = 0; i < n; i++) {
+        out[i] = static_cast<T>(next());
+      }
+    }
+
+    //! the current value, without advancing
+    double value() const { return _eval(d_phase); }
+
+  protected:
+    static const size_t TABLE_SIZE = 1024;
+
+    void _wrap()
+    {
+      d_phase -= std::floor(d_phase);
+      // Rounding can leave exactly 1.0 for tiny negative phases
+      if (d_phase >= 1.0) d_phase = 0.0;
+    }
+
+    double _eval(double phase) const
+    {
+      switch (d_shape) {
+        case TRIANGLE: {
+          double q = phase + 0.25;
+          if (q >= 1.0) q -= 1.0;
+          return 1.0 - (4.0 * std::fabs(q - 0.5));
+        }
+        case SQUARE:
+          return (phase < 0.5) ? 1.0 : -1.0;
+        default: {
+          const double pos = phase * TABLE_SIZE;
+          const size_t idx = static_cast<size_t>(pos);
+          return d_table[idx] + ((pos - idx) * (d_table[idx + 1] - d_table[idx]));
+        }
+      }
+    }
+
+    // One period of sin() plus a guard point, shared by all instances
+    static const double* _sine_table()
+    {
+      static const std::vector<double> table = []() {
+        std::vector<double> t(TABLE_SIZE + 1);
+        for (size_t i = 0; i <= TABLE_SIZE; i++) {
+          t[i] = std::sin((2.0 * 3.14159265358979323846 * i) / TABLE_SIZE);
+        }
+        return t;
+      }();
+      return &table[0];
+    }
+
+    const double d_samp_rate;
+    shape_t d_shape;
+    const double* d_table;
+    double d_phase_inc;
+    double d_phase;
+  };
+
+  } /* namespace guitar */
+} /* namespace gr */
+
+#endif /* INCLUDED_GUITAR_LFO_H */
@@ -0,0 +1,289 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2018 Ashish Chaudhari.
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "denormal.h"
+#include "multichannel_reverb_impl.h"
+
+namespace gr {
+  namespace guitar {
+
+    multichannel_reverb::sptr
+    multichannel_reverb::make(bool enabled, double samp_rate, int num_channels,
+        const std::string& comb_coeff_mode, const std::string& allpass_coeff_mode,
+        double wet_gamma, int crossfade_len, bool single_precision, int fdn_size,
+        int seed, bool ring_out)
+    {
+      return gnuradio::get_initial_sptr
+        (new multichannel_reverb_impl(enabled, samp_rate, num_channels,
+          comb_coeff_mode, allpass_coeff_mode, wet_gamma, crossfade_len, single_precision,
+          fdn_size, seed, ring_out));
+    }
+
+    /*
+     * The private constructor
+     */
+    multichannel_reverb_impl::multichannel_reverb_impl(bool enabled, double samp_rate,
+        int num_channels,
+        const std::string& comb_coeff_mode, const std::string& allpass_coeff_mode,
+        double wet_gamma, int crossfade_len, bool single_precision, int fdn_size,
+        int seed, bool ring_out)
+      : gr::sync_block("multichannel_reverb",
+        gr::io_signature::make(num_channels, num_channels, sizeof(float)),
+        gr::io_signature::make(num_channels, num_channels, sizeof(float))),
+        d_samp_rate(samp_rate), d_num_channels(num_channels),
+        d_single_precision(single_precision), d_fdn_size(fdn_size), d_bypass(enabled),
+        d_comb_coeff_mode(comb_coeff_mode), d_allpass_coeff_mode(allpass_coeff_mode), d_rng(seed),
+        d_wet_gamma(wet_gamma), d_crossfade_len(0), d_ring_out(ring_out),
+        d_kernels(NULL), d_old_kernels(NULL), d_fade_pos(0), d_fade_len(0), d_ringing(enabled),
+        d_cur_ring_out(ring_out)
+    {
+      setup_stats_port(this);
+      if (num_channels < 1) {
+        throw std::invalid_argument("multichannel_reverb: num_channels must be at least 1");
+      }
+      if (!reverb_kernel::valid_fdn_size(fdn_size)) {
+        throw std::invalid_argument("multichannel_reverb: fdn_size must be 0, 4, 8 or 16");
+      }
+      set_crossfade_len(crossfade_len);
+      d_kernels = new kernel_set(d_samp_rate, d_num_channels, d_fdn_size, d_single_precision);
+      _configure(d_kernels);
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    multichannel_reverb_impl::~multichannel_reverb_impl()
+    {
+      delete d_kernels;
+      delete d_old_kernels;
+    }
+
+    multichannel_reverb_impl::kernel_set::kernel_set(double samp_rate, int num_channels,
+        int fdn_size, bool single_precision)
+    {
+      const size_t nbytes = reverb_kernel::storage_size(samp_rate, fdn_size, single_precision);
+      arena.resize((num_channels * nbytes) + reverb_kernel::STORAGE_ALIGN - 1);
+      char* storage = reverb_kernel::align_storage(&arena[0]);
+      for (int c = 0; c < num_channels; c++) {
+        kernels.push_back(reverb_kernel::make(samp_rate, fdn_size, single_precision,
+          storage + (c * nbytes)));
+      }
+    }
+
+    multichannel_reverb_impl::kernel_set::~kernel_set()
+    {
+      for (size_t c = 0; c < kernels.size(); c++) {
+        delete kernels[c];
+      }
+    }
+
+    void
+    multichannel_reverb_impl::set_enabled(bool enabled)
+    {
+      d_bypass.set_enabled(enabled);
+    }
+
+    void
+    multichannel_reverb_impl::set_comb_coeff_mode(const std::string& comb_coeff_mode)
+    {
+      d_comb_coeff_mode = comb_coeff_mode;
+      _update_kernels();
+    }
+
+    void
+    multichannel_reverb_impl::set_allpass_coeff_mode(const std::string& allpass_coeff_mode)
+    {
+      d_allpass_coeff_mode = allpass_coeff_mode;
+      _update_kernels();
+    }
+
+    void
+    multichannel_reverb_impl::set_wet_gamma(double wet_gamma)
+    {
+      d_wet_gamma.set(wet_gamma);
+    }
+
+    void
+    multichannel_reverb_impl::set_crossfade_len(int crossfade_len)
+    {
+      if (crossfade_len < 0) {
+        throw std::invalid_argument("multichannel_reverb: crossfade_len must not be negative");
+      }
+      d_crossfade_len.set(crossfade_len);
+    }
+
+    void
+    multichannel_reverb_impl::set_ring_out(bool ring_out)
+    {
+      d_ring_out.set(ring_out);
+    }
+
+    void
+    multichannel_reverb_impl::_configure(kernel_set* kernels)
+    {
+      // Randomized modes get an independent draw per channel
+      std::vector<reverb_kernel::filt_config> comb_cfgs, allpass_cfgs;
+      for (int c = 0; c < d_num_channels; c++) {
+        reverb_kernel::design(d_samp_rate, d_comb_coeff_mode, d_allpass_coeff_mode, d_fdn_size,
+          d_rng, comb_cfgs, allpass_cfgs);
+        kernels->kernels[c]->configure(comb_cfgs, allpass_cfgs);
+      }
+    }
+
+    // Runs in the caller's thread, so that the design and the clearing
+    // of the delay lines stay off the scheduler thread. Once work() has
+    // retired a set, reconfiguring does not allocate.
+    void
+    multichannel_reverb_impl::_update_kernels()
+    {
+      kernel_set* kernels = d_new_kernels.reclaim();
+      if (kernels == NULL) {
+        kernels = new kernel_set(d_samp_rate, d_num_channels, d_fdn_size, d_single_precision);
+      }
+      _configure(kernels);
+      d_new_kernels.publish(kernels);
+    }
+
+    void
+    multichannel_reverb_impl::_swap_kernels()
+    {
+      // Finish the current crossfade before starting another one
+      if (d_old_kernels != NULL) {
+        return;
+      }
+      kernel_set* kernels = d_new_kernels.take();
+      if (kernels == NULL) {
+        return;
+      }
+      const int crossfade_len = d_crossfade_len.get();
+      if (crossfade_len > 0) {
+        d_old_kernels = d_kernels;
+        d_fade_pos = 0;
+        d_fade_len = crossfade_len;
+      } else {
+        d_new_kernels.retire(d_kernels);
+      }
+      d_kernels = kernels;
+    }
+
+    // Wet signal of n samples of one channel, fading out of
+    // d_old_kernels from fade_pos
+    void
+    multichannel_reverb_impl::_process(int channel, const float* in, float* wet, size_t n,
+        size_t fade_pos)
+    {
+      d_kernels->kernels[channel]->process(in, wet, n);
+      if (d_old_kernels != NULL && fade_pos < d_fade_len) {
+        const size_t nfade = std::min(n, d_fade_len - fade_pos);
+        d_old_kernels->kernels[channel]->crossfade_into(in, wet, nfade, fade_pos, d_fade_len);
+      }
+    }
+
+    void
+    multichannel_reverb_impl::setup_rpc()
+    {
+      setup_stats_rpc(this);
+    }
+
+    int
+    multichannel_reverb_impl::work(int noutput_items,
+        gr_vector_const_void_star &input_items,
+        gr_vector_void_star &output_items)
+    {
+      work_stats::timer timer(*this, noutput_items);
+      denormal_guard guard;
+      _swap_kernels();
+
+      // Parameter snapshot for this buffer, shared by all channels
+      bypass::fade fade;
+      const bypass::state_t state = d_bypass.snapshot(noutput_items, fade);
+      if (state == bypass::ACTIVE || (state == bypass::BYPASSED && !d_ringing)) {
+        d_cur_ring_out = d_ring_out.get();
+      }
+      const bool ring_out = d_cur_ring_out;
+      if (state == bypass::BYPASSED && !(ring_out && d_ringing)) {
+        d_ringing = false;
+        for (int c = 0; c < d_num_channels; c++) {
+          bypass::copy((const float *) input_items[c], (float *) output_items[c], noutput_items);
+        }
+        return noutput_items;
+      }
+      d_ringing = true;
+      smoothed_param<double>::ramp wet_gamma;
+      d_wet_gamma.snapshot(noutput_items, wet_gamma);
+      float peak = 0.0f;
+
+      // Run each channel over the whole buffer while its state is hot
+      for (int c = 0; c < d_num_channels; c++) {
+        const float *in = (const float *) input_items[c];
+        float *out = (float *) output_items[c];
+
+        if (state == bypass::ACTIVE || !ring_out) {
+          // Compute the wet signal in place in the output buffer
+          _process(c, in, out, noutput_items, d_fade_pos);
+          for (int i = 0; i < noutput_items; i++) {
+            const double g = wet_gamma.at(i);
+            out[i] = (g * out[i]) + ((1.0 - g) * in[i]);
+          }
+          if (state == bypass::FADING) {
+            fade.crossfade(in, out, noutput_items);
+          }
+        } else {
+          // Ringing out: the input of the reverb fades instead of its
+          // output, and the dry signal stays at unity
+          float faded[bypass::CHUNK_SIZE];
+          for (int offset = 0; offset < noutput_items; offset += bypass::CHUNK_SIZE) {
+            const int nitems = std::min<int>(bypass::CHUNK_SIZE, noutput_items - offset);
+            fade.fade_input(in + offset, faded, nitems, offset);
+            _process(c, faded, out + offset, nitems, d_fade_pos + offset);
+            for (int i = 0; i < nitems; i++) {
+              const double g = wet_gamma.at(offset + i);
+              const float wet = out[offset + i];
+              peak = std::max(peak, std::abs(wet));
+              out[offset + i] = (g * (wet - faded[i])) + in[offset + i];
+            }
+          }
+        }
+      }
+      if (state == bypass::BYPASSED && bypass::tail_done(peak)) {
+        d_ringing = false;
+      }
+
+      if (d_old_kernels != NULL) {
+        d_fade_pos += std::min<size_t>(noutput_items, d_fade_len - d_fade_pos);
+        if (d_fade_pos == d_fade_len) {
+          d_new_kernels.retire(d_old_kernels);
+          d_old_kernels = NULL;
+        }
+      }
+
+      return noutput_items;
+    }
+
+  } /* namespace guitar */
+} /* namespace gr */
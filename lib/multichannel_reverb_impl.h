@@ -0,0 +1,106 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2018 Ashish Chaudhari.
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GUITAR_MULTICHANNEL_REVERB_IMPL_H
+#define INCLUDED_GUITAR_MULTICHANNEL_REVERB_IMPL_H
+
+#include <guitar/multichannel_reverb.h>
+#include <boost/noncopyable.hpp>
+#include "bypass.h"
+#include "handoff.h"
+#include "param.h"
+#include "prng.h"
+#include "reverb_kernel.h"
+#include "work_stats.h"
+
+namespace gr {
+  namespace guitar {
+
+    class multichannel_reverb_impl : public multichannel_reverb, public work_stats
+    {
+     private:
+      // The kernels of all channels. Their delay lines live in arena.
+      struct kernel_set : boost::noncopyable {
+        kernel_set(double samp_rate, int num_channels, int fdn_size, bool single_precision);
+        ~kernel_set();
+
+        std::vector<char> arena;
+        std::vector<reverb_kernel*> kernels;
+      };
+
+      // Parameters
+      const double d_samp_rate;
+      const int d_num_channels;
+      const bool d_single_precision;
+      const int d_fdn_size;
+      bypass d_bypass;
+      std::string d_comb_coeff_mode;
+      std::string d_allpass_coeff_mode;
+      prng d_rng;
+      smoothed_param<double> d_wet_gamma;
+      param<int> d_crossfade_len;
+      param<bool> d_ring_out;
+
+      // Kernel sets configured by the setters, on their way to work().
+      // Sets that work() is done with are reused.
+      handoff<kernel_set> d_new_kernels;
+
+      // Filters. Owned by work(). While d_old_kernels is set the
+      // output fades from it to d_kernels.
+      kernel_set* d_kernels;
+      kernel_set* d_old_kernels;
+      size_t d_fade_pos;
+      size_t d_fade_len;
+      // Set while the tails are still audible
+      bool d_ringing;
+      // The ring_out in effect. Only follows d_ring_out while no fade
+      // or tail is under way, so a change can not cut a tail short.
+      bool d_cur_ring_out;
+
+      void _configure(kernel_set* kernels);
+      void _update_kernels();
+      void _swap_kernels();
+      void _process(int channel, const float* in, float* wet, size_t n, size_t fade_pos);
+
+     public:
+      multichannel_reverb_impl(bool enabled, double samp_rate, int num_channels,
+          const std::string& comb_coeff_mode, const std::string& allpass_coeff_mode,
+          double wet_gamma, int crossfade_len, bool single_precision, int fdn_size,
+          int seed, bool ring_out);
+      ~multichannel_reverb_impl();
+
+      // Where all the action really happens
+      int work(int noutput_items,
+         gr_vector_const_void_star &input_items,
+         gr_vector_void_star &output_items);
+      void setup_rpc();
+
+      void set_enabled(bool enabled);
+      void set_comb_coeff_mode(const std::string& comb_coeff_mode);
+      void set_allpass_coeff_mode(const std::string& allpass_coeff_mode);
+      void set_wet_gamma(double wet_gamma);
+      void set_crossfade_len(int crossfade_len);
+      void set_ring_out(bool ring_out);
+    };
+
+  } // namespace guitar
+} // namespace gr
+
+#endif /* INCLUDED_GUITAR_MULTICHANNEL_REVERB_IMPL_H */
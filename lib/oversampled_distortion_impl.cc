@@ -0,0 +1,202 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2018 Ashish Chaudhari.
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "oversampled_distortion_impl.h"
+
+namespace gr {
+  namespace guitar {
+
+    const int oversampled_distortion_impl::CHUNK_SIZE;
+
+    oversampled_distortion::sptr
+    oversampled_distortion::make(bool enabled, int factor,
+        const std::vector<double> &fftaps, const std::vector<double> &fbtaps,
+        std::string dist_func, double boost, double wet_gamma)
+    {
+      return gnuradio::get_initial_sptr
+        (new oversampled_distortion_impl(enabled, factor, fftaps, fbtaps,
+          dist_func, boost, wet_gamma));
+    }
+
+    /*
+     * The private constructor
+     */
+    oversampled_distortion_impl::oversampled_distortion_impl(bool enabled, int factor,
+        const std::vector<double> &fftaps, const std::vector<double> &fbtaps,
+        std::string dist_func, double boost, double wet_gamma)
+      : gr::sync_block("oversampled_distortion",
+        gr::io_signature::make(1, 1, sizeof(float)),
+        gr::io_signature::make(1, 1, sizeof(float))),
+        d_factor(factor), d_bypass(enabled), d_boost(boost), d_wet_gamma(wet_gamma),
+        d_filters(NULL), d_shaper(NULL)
+    {
+      setup_stats_port(this);
+      if (factor < 1) {
+        throw std::invalid_argument("oversampled_distortion: factor must be at least 1");
+      }
+      d_filters = new filters(factor, fftaps, fbtaps);
+      d_shaper = new waveshaper(dist_func, boost);
+      d_scratch.resize(CHUNK_SIZE * factor);
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    oversampled_distortion_impl::~oversampled_distortion_impl()
+    {
+      delete d_filters;
+      delete d_shaper;
+    }
+
+    oversampled_distortion_impl::filters::filters(int factor,
+        const std::vector<double> &fftaps, const std::vector<double> &fbtaps)
+      : interp(factor, _interp_taps(factor, fftaps), fbtaps),
+        decim(factor, fftaps, fbtaps)
+    {
+    }
+
+    // Zero-stuffing divides the signal level by the oversampling
+    // factor, so fold the makeup gain into the interpolation filter
+    std::vector<double>
+    oversampled_distortion_impl::_interp_taps(int factor, const std::vector<double> &fftaps)
+    {
+      std::vector<double> taps(fftaps);
+      for (size_t i = 0; i < taps.size(); i++) {
+        taps[i] *= factor;
+      }
+      return taps;
+    }
+
+    void
+    oversampled_distortion_impl::set_enabled(bool enabled)
+    {
+      d_bypass.set_enabled(enabled);
+    }
+
+    void
+    oversampled_distortion_impl::set_taps(const std::vector<double> &fftaps,
+          const std::vector<double> &fbtaps)
+    {
+      // Built here, so that bad taps throw in the caller and work()
+      // only swaps the filters in
+      d_new_filters.publish(new filters(d_factor, fftaps, fbtaps));
+    }
+
+    void
+    oversampled_distortion_impl::set_dist_func(std::string dist_func)
+    {
+      // Validate and build the table here, so that work() only swaps
+      // in the finished waveshaper
+      if (!waveshaper::valid_dist_func(dist_func)) {
+        throw std::invalid_argument("oversampled_distortion: Distortion function not supported.");
+      }
+      d_new_shapers.publish(new waveshaper(dist_func, d_boost.get()));
+    }
+
+    void
+    oversampled_distortion_impl::set_boost(double boost)
+    {
+      d_boost.set(boost);
+    }
+
+    void
+    oversampled_distortion_impl::set_wet_gamma(double wet_gamma)
+    {
+      d_wet_gamma.set(wet_gamma);
+    }
+
+    // The filters carry on from the current state when the number of
+    // taps is unchanged
+    void
+    oversampled_distortion_impl::_swap_stages()
+    {
+      filters* f = d_new_filters.take();
+      if (f != NULL) {
+        if (f->interp.same_order(d_filters->interp)) {
+          f->interp.copy_state(d_filters->interp);
+          f->decim.copy_state(d_filters->decim);
+        }
+        d_new_filters.retire(d_filters);
+        d_filters = f;
+      }
+      waveshaper* shaper = d_new_shapers.take();
+      if (shaper != NULL) {
+        d_new_shapers.retire(d_shaper);
+        d_shaper = shaper;
+      }
+    }
+
+    void
+    oversampled_distortion_impl::setup_rpc()
+    {
+      setup_stats_rpc(this);
+    }
+
+    int
+    oversampled_distortion_impl::work(int noutput_items,
+        gr_vector_const_void_star &input_items,
+        gr_vector_void_star &output_items)
+    {
+      work_stats::timer timer(*this, noutput_items);
+      denormal_guard guard;
+      const float *in = (const float *) input_items[0];
+      float *out = (float *) output_items[0];
+
+      bypass::fade fade;
+      const bypass::state_t state = d_bypass.snapshot(noutput_items, fade);
+      if (state == bypass::BYPASSED) {
+        bypass::copy(in, out, noutput_items);
+        return noutput_items;
+      }
+
+      _swap_stages();
+      // The boost only scales the table index, so it is set here
+      d_shaper->set_boost(d_boost.get());
+#ifdef GUITAR_DENORMAL_OFFSET
+      const double denormal = d_denormal.next();
+      d_filters->interp.offset_state(denormal);
+      d_filters->decim.offset_state(denormal);
+#endif
+      const double wet_gamma = d_wet_gamma.get();
+
+      // Run all three stages on one chunk at a time so that the
+      // oversampled signal stays in the scratch buffer
+      for (int offset = 0; offset < noutput_items; offset += CHUNK_SIZE) {
+        const int nitems = std::min<int>(CHUNK_SIZE, noutput_items - offset);
+        float *scratch = &d_scratch[0];
+
+        d_filters->interp.interpolate(in + offset, scratch, nitems);
+        d_shaper->process(scratch, scratch, nitems * d_factor, true, wet_gamma);
+        d_filters->decim.decimate(scratch, out + offset, nitems);
+      }
+      if (state == bypass::FADING) {
+        fade.crossfade(in, out, noutput_items);
+      }
+
+      return noutput_items;
+    }
+
+  } /* namespace guitar */
+} /* namespace gr */
@@ -0,0 +1,96 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2018 Ashish Chaudhari.
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GUITAR_OVERSAMPLED_DISTORTION_IMPL_H
+#define INCLUDED_GUITAR_OVERSAMPLED_DISTORTION_IMPL_H
+
+#include <guitar/oversampled_distortion.h>
+#include "bypass.h"
+#include "denormal.h"
+#include "handoff.h"
+#include "param.h"
+#include "polyphase_iir_filter.h"
+#include "waveshaper.h"
+#include "work_stats.h"
+
+namespace gr {
+  namespace guitar {
+
+    class oversampled_distortion_impl : public oversampled_distortion, public work_stats
+    {
+     private:
+      static const int CHUNK_SIZE = 256;
+
+      // The interpolation and decimation filters, which set_taps()
+      // replaces together
+      struct filters {
+        filters(int factor, const std::vector<double> &fftaps,
+            const std::vector<double> &fbtaps);
+
+        polyphase_iir_filter<float,float,double> interp;
+        polyphase_iir_filter<float,float,double> decim;
+      };
+
+      // Parameters
+      const int d_factor;
+      bypass d_bypass;
+      param<double> d_boost;
+      param<double> d_wet_gamma;
+
+      // Stages built by the setters, on their way to work()
+      handoff<filters> d_new_filters;
+      handoff<waveshaper> d_new_shapers;
+
+      // Processing stages. Owned by work().
+      filters* d_filters;
+      waveshaper* d_shaper;
+#ifdef GUITAR_DENORMAL_OFFSET
+      denormal_offset d_denormal;
+#endif
+
+      // Oversampled signal for CHUNK_SIZE input samples
+      std::vector<float> d_scratch;
+
+      static std::vector<double> _interp_taps(int factor, const std::vector<double> &fftaps);
+      void _swap_stages();
+
+     public:
+      oversampled_distortion_impl(bool enabled, int factor,
+          const std::vector<double> &fftaps, const std::vector<double> &fbtaps,
+          std::string dist_func, double boost, double wet_gamma);
+      ~oversampled_distortion_impl();
+
+      void set_enabled(bool enabled);
+      void set_taps(const std::vector<double> &fftaps, const std::vector<double> &fbtaps);
+      void set_dist_func(std::string dist_func);
+      void set_boost(double boost);
+      void set_wet_gamma(double wet_gamma);
+
+      // Where all the action really happens
+      int work(int noutput_items,
+         gr_vector_const_void_star &input_items,
+         gr_vector_void_star &output_items);
+      void setup_rpc();
+    };
+
+  } // namespace guitar
+} // namespace gr
+
+#endif /* INCLUDED_GUITAR_OVERSAMPLED_DISTORTION_IMPL_H */
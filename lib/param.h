@@ -0,0 +1,139 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_PARAM_H
+#define INCLUDED_PARAM_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+namespace gr {
+  namespace guitar {
+
+  /*!
+   * \brief a block parameter set from a controller thread and read by
+   * work() on the scheduler thread
+   *
+   * The value is a relaxed atomic: each set() is seen whole and
+   * eventually, with no ordering against other parameters. work()
+   * should get() every parameter once per buffer into a local so the
+   * hot loop runs on a register copy.
+   */
+  template<class T>
+  class param
+  {
+  public:
+    explicit param(T init = T()): d_value(init) {}
+
+    void set(T val) { d_value.store(val, std::memory_order_relaxed); }
+    T get() const { return d_value.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<T> d_value;
+  };
+
+  /*!
+   * \brief a param that work() moves to linearly instead of jumping
+   *
+   * When the target changes, the value ramps from where it is to the
+   * new target over ramp_len samples, whatever the buffer size: the
+   * ramp can end inside a buffer, and the samples after it take the
+   * target. A target change during a ramp starts a new ramp from the
+   * current value. A ramp_len of 0 makes every change immediate.
+   */
+  template<class T>
+  class smoothed_param
+  {
+  public:
+    static const int DEFAULT_RAMP_LEN = 256;
+
+    /*!
+     * \brief the ramp over one buffer, from snapshot()
+     *
+     * Sample i (from 0) takes start + (i + 1) * step for i < len, and
+     * target after that.
+     */
+    struct ramp
+    {
+      T start;
+      T step;
+      size_t len;
+      T target;
+
+      T at(size_t i) const
+      {
+        return (i < len) ? (start + (static_cast<T>(i + 1) * step)) : target;
+      }
+    };
+
+    explicit smoothed_param(T init = T(), int ramp_len = DEFAULT_RAMP_LEN):
+      d_target(init), d_ramp_len(ramp_len),
+      d_value(init), d_ramp_to(init), d_step(0), d_ramp_left(0) {}
+
+    //! set a new target. Any thread.
+    void set(T val) { d_target.set(val); }
+    void set_ramp_len(int ramp_len) { d_ramp_len.set(ramp_len); }
+
+    //! the last target set. Any thread.
+    T target() const { return d_target.get(); }
+
+    //! take a snapshot for a buffer of \p n samples. work() only.
+    void snapshot(size_t n, ramp& r)
+    {
+      const T target = d_target.get();
+      if (target != d_ramp_to) {
+        d_ramp_to = target;
+        d_ramp_left = static_cast<size_t>(std::max(d_ramp_len.get(), 0));
+        if (d_ramp_left == 0) {
+          d_value = target;
+        } else {
+          d_step = (target - d_value) / static_cast<T>(d_ramp_left);
+        }
+      }
+
+      r.start = d_value;
+      r.target = d_ramp_to;
+      if (d_ramp_left == 0) {
+        r.step = T(0);
+        r.len = 0;
+        return;
+      }
+      // An empty buffer leaves the ramp where it is
+      r.step = d_step;
+      r.len = std::min(n, d_ramp_left);
+      d_ramp_left -= r.len;
+      d_value = (d_ramp_left == 0) ? d_ramp_to : (d_value + (static_cast<T>(r.len) * d_step));
+    }
+
+  private:
+    param<T> d_target;
+    param<int> d_ramp_len;
+    // Owned by work()
+    T d_value;
+    T d_ramp_to;
+    T d_step;
+    size_t d_ramp_left;
+  };
+
+  } /* namespace guitar */
+} /* namespace gr */
+
+#endif /* INCLUDED_PARAM_H */
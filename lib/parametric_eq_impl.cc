@@ -0,0 +1,251 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2018 Ashish Chaudhari.
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <stdexcept>
+#include "parametric_eq_impl.h"
+
+namespace gr {
+  namespace guitar {
+
+    parametric_eq::sptr
+    parametric_eq::make(double samp_rate, int num_channels,
+        const std::vector<std::string> &types, const std::vector<double> &gains,
+        const std::vector<double> &cutoff_freqs, const std::vector<double> &qs)
+    {
+      return gnuradio::get_initial_sptr
+        (new parametric_eq_impl(samp_rate, num_channels, types, gains, cutoff_freqs, qs));
+    }
+
+    /*
+     * The private constructor
+     */
+    parametric_eq_impl::parametric_eq_impl(double samp_rate, int num_channels,
+        const std::vector<std::string> &types, const std::vector<double> &gains,
+        const std::vector<double> &cutoff_freqs, const std::vector<double> &qs)
+      : gr::sync_block("parametric_eq",
+        gr::io_signature::make(num_channels, num_channels, sizeof(float)),
+        gr::io_signature::make(num_channels, num_channels, sizeof(float))),
+        d_samp_rate(samp_rate), d_num_channels(num_channels), d_bank(NULL)
+    {
+      setup_stats_port(this);
+      if (num_channels < 1) {
+        throw std::invalid_argument("parametric_eq: num_channels must be at least 1");
+      }
+      const std::vector<biquad::coeffs> sections = _design(types, gains, cutoff_freqs, qs);
+      d_bank = new filter_bank(num_channels);
+      d_bank->set_sections(sections);
+    }
+
+    /*
+     * Our virtual destructor.
+     */
+    parametric_eq_impl::~parametric_eq_impl()
+    {
+      delete d_bank;
+    }
+
+    parametric_eq_impl::filter_bank::filter_bank(int num_channels)
+    {
+      for (int c = 0; (c + LANES) <= num_channels; c += LANES) {
+        d_lane_filters.push_back(new biquad_cascade<double, LANES>());
+      }
+      for (int c = (num_channels / LANES) * LANES; c < num_channels; c++) {
+        d_single_filters.push_back(new biquad_cascade<double, 1>());
+      }
+    }
+
+    parametric_eq_impl::filter_bank::~filter_bank()
+    {
+      for (size_t i = 0; i < d_lane_filters.size(); i++) {
+        delete d_lane_filters[i];
+      }
+      for (size_t i = 0; i < d_single_filters.size(); i++) {
+        delete d_single_filters[i];
+      }
+    }
+
+    // Installs the sections with their state at zero
+    void
+    parametric_eq_impl::filter_bank::set_sections(const std::vector<biquad::coeffs> &sections)
+    {
+      for (size_t i = 0; i < d_lane_filters.size(); i++) {
+        d_lane_filters[i]->set_sections(sections);
+        d_lane_filters[i]->reset();
+      }
+      for (size_t i = 0; i < d_single_filters.size(); i++) {
+        d_single_filters[i]->set_sections(sections);
+        d_single_filters[i]->reset();
+      }
+    }
+
+    size_t
+    parametric_eq_impl::filter_bank::num_sections() const
+    {
+      if (!d_lane_filters.empty()) {
+        return d_lane_filters[0]->num_sections();
+      }
+      return d_single_filters[0]->num_sections();
+    }
+
+    void
+    parametric_eq_impl::filter_bank::copy_state(const filter_bank &other)
+    {
+      for (size_t i = 0; i < d_lane_filters.size(); i++) {
+        d_lane_filters[i]->copy_state(*other.d_lane_filters[i]);
+      }
+      for (size_t i = 0; i < d_single_filters.size(); i++) {
+        d_single_filters[i]->copy_state(*other.d_single_filters[i]);
+      }
+    }
+
+    void
+    parametric_eq_impl::filter_bank::offset_state(double offset)
+    {
+      for (size_t i = 0; i < d_lane_filters.size(); i++) {
+        d_lane_filters[i]->offset_state(offset);
+      }
+      for (size_t i = 0; i < d_single_filters.size(); i++) {
+        d_single_filters[i]->offset_state(offset);
+      }
+    }
+
+    void
+    parametric_eq_impl::filter_bank::filter_n(gr_vector_const_void_star &input_items,
+        gr_vector_void_star &output_items, int n)
+    {
+      const float *in[LANES];
+      float *out[LANES];
+      int chan = 0;
+      for (size_t i = 0; i < d_lane_filters.size(); i++) {
+        for (int c = 0; c < LANES; c++, chan++) {
+          in[c] = (const float *) input_items[chan];
+          out[c] = (float *) output_items[chan];
+        }
+        d_lane_filters[i]->filter_n(in, out, n);
+      }
+      for (size_t i = 0; i < d_single_filters.size(); i++, chan++) {
+        in[0] = (const float *) input_items[chan];
+        out[0] = (float *) output_items[chan];
+        d_single_filters[i]->filter_n(in, out, n);
+      }
+    }
+
+    std::vector<biquad::coeffs>
+    parametric_eq_impl::_design(const std::vector<std::string> &types,
+        const std::vector<double> &gains,
+        const std::vector<double> &cutoff_freqs,
+        const std::vector<double> &qs) const
+    {
+      if (gains.size() != types.size() || cutoff_freqs.size() != types.size() ||
+          qs.size() != types.size()) {
+        throw std::invalid_argument("parametric_eq: types, gains, cutoff_freqs and qs must have the same length");
+      }
+
+      std::vector<biquad::coeffs> sections;
+      for (size_t s = 0; s < types.size(); s++) {
+        biquad::filt_type type;
+        if (!biquad::parse_type(types[s], type)) {
+          throw std::invalid_argument("parametric_eq: Invalid filter type. Must be in {low-shelf, high-shelf, peaking, lowpass, highpass}");
+        }
+        if (cutoff_freqs[s] <= 0.0) {
+          throw std::invalid_argument("parametric_eq: cutoff_freq must be greater than 0");
+        }
+        if (cutoff_freqs[s] >= d_samp_rate/2) {
+          throw std::invalid_argument("parametric_eq: cutoff_freq must be less than half the samp_rate");
+        }
+        if (qs[s] <= 0.0) {
+          throw std::invalid_argument("parametric_eq: q must be greater than 0");
+        }
+        sections.push_back(biquad::design(type, d_samp_rate, gains[s], cutoff_freqs[s], qs[s]));
+      }
+      return sections;
+    }
+
+    // Runs in the caller's thread, so that work() neither allocates
+    // nor sizes the cascades. Once work() has retired a bank with as
+    // many sections, installing the next one does not allocate.
+    void
+    parametric_eq_impl::_update_bank(const std::vector<biquad::coeffs> &sections)
+    {
+      filter_bank* bank = d_new_banks.reclaim();
+      if (bank == NULL) {
+        bank = new filter_bank(d_num_channels);
+      }
+      bank->set_sections(sections);
+      d_new_banks.publish(bank);
+    }
+
+    // The filters carry on from the current state when only the
+    // coefficients change. A different number of sections starts
+    // from zero.
+    void
+    parametric_eq_impl::_swap_banks()
+    {
+      filter_bank* bank = d_new_banks.take();
+      if (bank == NULL) {
+        return;
+      }
+      if (bank->num_sections() == d_bank->num_sections()) {
+        bank->copy_state(*d_bank);
+      }
+      d_new_banks.retire(d_bank);
+      d_bank = bank;
+    }
+
+    void
+    parametric_eq_impl::set_sections(const std::vector<std::string> &types,
+        const std::vector<double> &gains,
+        const std::vector<double> &cutoff_freqs,
+        const std::vector<double> &qs)
+    {
+      // Design here so that invalid parameters throw in the caller
+      _update_bank(_design(types, gains, cutoff_freqs, qs));
+    }
+
+    void
+    parametric_eq_impl::setup_rpc()
+    {
+      setup_stats_rpc(this);
+    }
+
+    int
+    parametric_eq_impl::work(int noutput_items,
+        gr_vector_const_void_star &input_items,
+        gr_vector_void_star &output_items)
+    {
+      work_stats::timer timer(*this, noutput_items);
+      denormal_guard guard;
+      _swap_banks();
+#ifdef GUITAR_DENORMAL_OFFSET
+      d_bank->offset_state(d_denormal.next());
+#endif
+
+      d_bank->filter_n(input_items, output_items, noutput_items);
+
+      return noutput_items;
+    }
+
+  } /* namespace guitar */
+} /* namespace gr */
@@ -0,0 +1,98 @@
+/* -*- c++ -*- */
+/* 
+ * Copyright 2018 Ashish Chaudhari.
+ * 
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ * 
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GUITAR_PARAMETRIC_EQ_IMPL_H
+#define INCLUDED_GUITAR_PARAMETRIC_EQ_IMPL_H
+
+#include <guitar/parametric_eq.h>
+#include "biquad_cascade.h"
+#include "denormal.h"
+#include "handoff.h"
+#include "work_stats.h"
+
+namespace gr {
+  namespace guitar {
+
+    class parametric_eq_impl : public parametric_eq, public work_stats
+    {
+     private:
+      static const int LANES = 4;
+
+      // The cascades of all channels. Full groups of LANES channels
+      // run as one vector cascade, the remaining channels one at a time.
+      class filter_bank
+      {
+      public:
+        explicit filter_bank(int num_channels);
+        ~filter_bank();
+
+        void set_sections(const std::vector<biquad::coeffs> &sections);
+        size_t num_sections() const;
+        void copy_state(const filter_bank &other);
+        void offset_state(double offset);
+        void filter_n(gr_vector_const_void_star &input_items,
+            gr_vector_void_star &output_items, int n);
+
+      private:
+        std::vector< biquad_cascade<double, LANES>* > d_lane_filters;
+        std::vector< biquad_cascade<double, 1>* > d_single_filters;
+      };
+
+      const double d_samp_rate;
+      const int d_num_channels;
+
+      // Banks set up by set_sections(), on their way to work(). Banks
+      // that work() is done with are reused.
+      handoff<filter_bank> d_new_banks;
+      // Owned by work()
+      filter_bank* d_bank;
+#ifdef GUITAR_DENORMAL_OFFSET
+      denormal_offset d_denormal;
+#endif
+
+      std::vector<biquad::coeffs> _design(const std::vector<std::string> &types,
+          const std::vector<double> &gains,
+          const std::vector<double> &cutoff_freqs,
+          const std::vector<double> &qs) const;
+      void _update_bank(const std::vector<biquad::coeffs> &sections);
+      void _swap_banks();
+
+     public:
+      parametric_eq_impl(double samp_rate, int num_channels,
+          const std::vector<std::string> &types, const std::vector<double> &gains,
+          const std::vector<double> &cutoff_freqs, const std::vector<double> &qs);
+      ~parametric_eq_impl();
+
+      void set_sections(const std::vector<std::string> &types,
+          const std::vector<double> &gains,
+          const std::vector<double> &cutoff_freqs,
+          const std::vector<double> &qs);
+
+      // Where all the action really happens
+      int work(int noutput_items,
+         gr_vector_const_void_star &input_items,
+         gr_vector_void_star &output_items);
+      void setup_rpc();
+    };
+
+  } // namespace guitar
+} // namespace gr
+
+#endif /* INCLUDED_GUITAR_PARAMETRIC_EQ_IMPL_H */
@@ -0,0 +1,193 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <stdexcept>
+#include "partitioned_convolver.h"
+
+namespace gr {
+  namespace guitar {
+
+    static size_t
+    _next_pow2(size_t n)
+    {
+      size_t p = 1;
+      while (p < n) p <<= 1;
+      return p;
+    }
+
+    static bool
+    _is_pow2(size_t n)
+    {
+      return (n != 0) && ((n & (n - 1)) == 0);
+    }
+
+    partitioned_convolver::stage::stage(const std::vector<float>& ir,
+        size_t size_, size_t offset_, size_t num_parts_)
+      : size(size_), offset(offset_), num_parts(num_parts_), num_bins(size_ + 1),
+        fft(new real_fft(2 * size_)),
+        ir_re(num_parts_ * num_bins), ir_im(num_parts_ * num_bins),
+        fdl_re(num_parts_ * num_bins, 0.0f), fdl_im(num_parts_ * num_bins, 0.0f),
+        fdl_idx(0), acc_re(num_bins), acc_im(num_bins), buf(2 * size_)
+    {
+      const float scale = 1.0f / (2 * size);
+      for (size_t j = 0; j < num_parts; j++) {
+        std::fill(buf.begin(), buf.end(), 0.0f);
+        const size_t start = std::min(offset + (j * size), ir.size());
+        const size_t end = std::min(start + size, ir.size());
+        for (size_t i = start; i < end; i++) {
+          buf[i - start] = ir[i] * scale;
+        }
+        fft->forward(&buf[0], &ir_re[j * num_bins], &ir_im[j * num_bins]);
+      }
+    }
+
+    partitioned_convolver::stage::~stage()
+    {
+      delete fft;
+    }
+
+    partitioned_convolver::partitioned_convolver(const std::vector<float>& ir,
+        size_t first_partition, size_t max_partition)
+      : d_block_size(first_partition), d_time(0)
+    {
+      if (!_is_pow2(first_partition) || first_partition < 2 ||
+          !_is_pow2(max_partition) || max_partition < 2) {
+        throw std::invalid_argument("partitioned_convolver: Partition sizes must be powers of two");
+      }
+      max_partition = std::max(max_partition, first_partition);
+
+      // Two partitions per size until the largest, which takes the rest
+      size_t offset = 0, size = first_partition;
+      do {
+        const size_t remaining = (ir.size() > offset) ? ((ir.size() - offset + size - 1) / size) : 1;
+        const size_t num_parts = (size < max_partition) ? std::min<size_t>(2, remaining) : remaining;
+        d_stages.push_back(new stage(ir, size, offset, num_parts));
+        offset += num_parts * size;
+        size = std::min(2 * size, max_partition);
+      } while (offset < ir.size());
+
+      // Enough input history for the largest FFT and enough output
+      // for everything up to the end of the last stage
+      d_input.resize(2 * d_stages.back()->size);
+      d_input_mask = d_input.size() - 1;
+      d_output.resize(_next_pow2(d_stages.back()->offset + d_block_size));
+      d_output_mask = d_output.size() - 1;
+      reset();
+    }
+
+    partitioned_convolver::~partitioned_convolver()
+    {
+      for (size_t s = 0; s < d_stages.size(); s++) {
+        delete d_stages[s];
+      }
+    }
+
+    void
+    partitioned_convolver::reset()
+    {
+      std::fill(d_input.begin(), d_input.end(), 0.0f);
+      std::fill(d_output.begin(), d_output.end(), 0.0f);
+      for (size_t s = 0; s < d_stages.size(); s++) {
+        std::fill(d_stages[s]->fdl_re.begin(), d_stages[s]->fdl_re.end(), 0.0f);
+        std::fill(d_stages[s]->fdl_im.begin(), d_stages[s]->fdl_im.end(), 0.0f);
+        d_stages[s]->fdl_idx = 0;
+      }
+      d_time = 0;
+    }
+
+    void
+    partitioned_convolver::process(const float* in, float* out, size_t n)
+    {
+      while (n > 0) {
+        // Run up to the next block boundary
+        const size_t run = std::min(n, d_block_size - (d_time % d_block_size));
+        for (size_t i = 0; i < run; i++) {
+          const size_t t = d_time + i;
+          d_input[t & d_input_mask] = in[i];
+          float& y = d_output[(t - d_block_size) & d_output_mask];
+          out[i] = y;
+          y = 0.0f;
+        }
+        d_time += run;
+        in += run;
+        out += run;
+        n -= run;
+
+        if (d_time % d_block_size == 0) {
+          for (size_t s = 0; s < d_stages.size(); s++) {
+            if (d_time % d_stages[s]->size == 0) {
+              _fire(d_stages[s]);
+            }
+          }
+        }
+      }
+    }
+
+    // Convolve the last P input samples with the stage's segment and
+    // add the result to the pending output
+    void
+    partitioned_convolver::_fire(stage* s)
+    {
+      const size_t P = s->size;
+      const size_t num_bins = s->num_bins;
+
+      // Overlap-save: transform the last 2P input samples
+      for (size_t i = 0; i < 2 * P; i++) {
+        s->buf[i] = d_input[(d_time - (2 * P) + i) & d_input_mask];
+      }
+      float* x_re = &s->fdl_re[s->fdl_idx * num_bins];
+      float* x_im = &s->fdl_im[s->fdl_idx * num_bins];
+      s->fft->forward(&s->buf[0], x_re, x_im);
+
+      // Multiply-accumulate partition j with the input from j blocks ago
+      float* acc_re = &s->acc_re[0];
+      float* acc_im = &s->acc_im[0];
+      std::fill(acc_re, acc_re + num_bins, 0.0f);
+      std::fill(acc_im, acc_im + num_bins, 0.0f);
+      size_t x_idx = s->fdl_idx;
+      for (size_t j = 0; j < s->num_parts; j++) {
+        const float* h_re = &s->ir_re[j * num_bins];
+        const float* h_im = &s->ir_im[j * num_bins];
+        const float* xj_re = &s->fdl_re[x_idx * num_bins];
+        const float* xj_im = &s->fdl_im[x_idx * num_bins];
+        for (size_t k = 0; k < num_bins; k++) {
+          acc_re[k] += (xj_re[k] * h_re[k]) - (xj_im[k] * h_im[k]);
+          acc_im[k] += (xj_re[k] * h_im[k]) + (xj_im[k] * h_re[k]);
+        }
+        x_idx = (x_idx == 0) ? (s->num_parts - 1) : (x_idx - 1);
+      }
+      s->fdl_idx = (s->fdl_idx + 1) % s->num_parts;
+
+      // The last P samples are the linear convolution of the block,
+      // which lands offset samples later in the output
+      s->fft->inverse(acc_re, acc_im, &s->buf[0]);
+      const size_t out_start = d_time - P + s->offset;
+      for (size_t i = 0; i < P; i++) {
+        d_output[(out_start + i) & d_output_mask] += s->buf[P + i];
+      }
+    }
+
+  } /* namespace guitar */
+} /* namespace gr */
@@ -0,0 +1,103 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GUITAR_PARTITIONED_CONVOLVER_H
+#define INCLUDED_GUITAR_PARTITIONED_CONVOLVER_H
+
+#include <boost/noncopyable.hpp>
+#include <cstddef>
+#include <vector>
+#include "real_fft.h"
+
+namespace gr {
+  namespace guitar {
+
+    //  Convolution with a long impulse response using non-uniformly
+    //  partitioned overlap-save FFT convolution.
+    //
+    //  The impulse response is split into segments, each handled by a
+    //  stage that runs a uniformly partitioned convolution with a
+    //  frequency domain delay line. The first stage uses partitions of
+    //  first_partition samples, which sets the latency. Every following
+    //  stage doubles the partition size up to max_partition, and the
+    //  last stage covers the rest of the impulse response. A stage with
+    //  partitions of P samples starts at least P - first_partition
+    //  samples into the impulse response, so its output is always
+    //  ready in time even though it is only computed every P samples.
+    //
+    //  Small partitions keep the latency low but cost an FFT pair every
+    //  few samples; the large partitions of the tail keep the cost per
+    //  sample low for impulse responses that are seconds long.
+    class partitioned_convolver : boost::noncopyable
+    {
+     public:
+      static const size_t MAX_PARTITION = 8192;
+
+      //! first_partition and max_partition must be powers of two, at
+      //! least 2. max_partition is raised to first_partition if smaller.
+      partitioned_convolver(const std::vector<float>& ir, size_t first_partition,
+          size_t max_partition = MAX_PARTITION);
+      ~partitioned_convolver();
+
+      //! Delay of the output in samples, which is first_partition
+      size_t latency() const { return d_block_size; }
+
+      //! Convolve n samples. out is the convolution delayed by
+      //! latency() samples. in and out may alias.
+      void process(const float* in, float* out, size_t n);
+
+      //! Clear the input history and pending output
+      void reset();
+
+     private:
+      // One uniformly partitioned segment of the impulse response
+      struct stage : boost::noncopyable {
+        stage(const std::vector<float>& ir, size_t size_, size_t offset_, size_t num_parts_);
+        ~stage();
+
+        const size_t size;        // Partition size P
+        const size_t offset;      // Start of the segment in the IR
+        const size_t num_parts;
+        const size_t num_bins;    // P + 1
+        real_fft* fft;
+        // Spectra of the IR partitions, scaled by 1 / (2 * P)
+        std::vector<float> ir_re, ir_im;
+        // Frequency domain delay line of input spectra
+        std::vector<float> fdl_re, fdl_im;
+        size_t fdl_idx;
+        std::vector<float> acc_re, acc_im;
+        std::vector<float> buf;   // 2 * P samples
+      };
+
+      void _fire(stage* s);
+
+      const size_t d_block_size;
+      std::vector<stage*> d_stages;
+      std::vector<float> d_input;
+      size_t d_input_mask;
+      std::vector<float> d_output;
+      size_t d_output_mask;
+      size_t d_time;
+    };
+
+  } // namespace guitar
+} // namespace gr
+
+#endif /* INCLUDED_GUITAR_PARTITIONED_CONVOLVER_H */
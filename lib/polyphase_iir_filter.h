@@ -0,0 +1,250 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_POLYPHASE_IIR_FILTER_H
+#define INCLUDED_POLYPHASE_IIR_FILTER_H
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace gr {
+  namespace guitar {
+
+  /*!
+   * \brief class template for an IIR filter running at a resampled rate
+   *
+   * Implements the same transfer function as
+   * filter::kernel::iir_filter (with oldstyle = false):
+   *
+   *   y(n) = sum_k fftaps[k]*x(n-k) - sum_{k>=1} fbtaps[k]*y(n-k)
+   *
+   * but splits it into a feedforward FIR stage and an all-pole
+   * feedback stage so that each stage runs only where it is needed.
+   *
+   * For interpolation the input is zero-stuffed, so the feedforward
+   * stage is decomposed into \p interp polyphase branches that only
+   * see the real (non-zero) input samples. The all-pole stage runs at
+   * the output rate.
+   *
+   * For decimation the filter is run in direct form II: the all-pole
+   * recursion runs at the input rate, but the feedforward sum over its
+   * state is only evaluated for the samples that are kept.
+   *
+   * A single instance should be used either for interpolate() or for
+   * decimate(), not both.
+   */
+  template<class o_type, class i_type, class tap_type>
+  class polyphase_iir_filter
+  {
+  public:
+    /*!
+     * \brief construct a filter for a rate change of \p rate
+     */
+    polyphase_iir_filter(unsigned rate,
+      const std::vector<tap_type>& fftaps, const std::vector<tap_type>& fbtaps):
+        d_rate(rate), d_nphase_taps(0), d_nff(0), d_nfb(0),
+        d_input_idx(0), d_output_idx(0)
+    {
+      if (rate < 1) {
+        throw std::invalid_argument("polyphase_iir_filter: rate must be at least 1");
+      }
+      set_taps(fftaps, fbtaps);
+    }
+
+    /*!
+     * \brief install new taps. fbtaps[0] is assumed to be 1.
+     *
+     * Resets the filter state if the number of taps changes.
+     */
+    void set_taps(const std::vector<tap_type>& fftaps, const std::vector<tap_type>& fbtaps)
+    {
+      if (fftaps.empty()) {
+        throw std::invalid_argument("polyphase_iir_filter: fftaps must not be empty");
+      }
+      const size_t nphase_taps = (fftaps.size() + d_rate - 1) / d_rate;
+      const size_t nff = fftaps.size();
+      const size_t nfb = (fbtaps.size() > 1) ? (fbtaps.size() - 1) : 0;
+
+      // Polyphase decomposition of the feedforward taps. Phase p holds
+      // fftaps[p], fftaps[p + rate], ... padded with zeros.
+      d_phase_taps.assign(d_rate * nphase_taps, tap_type(0.0));
+      for (size_t k = 0; k < fftaps.size(); k++) {
+        d_phase_taps[((k % d_rate) * nphase_taps) + (k / d_rate)] = fftaps[k];
+      }
+      d_fftaps = fftaps;
+      // Feedback taps, negated and without the leading 1
+      d_fbtaps.resize(nfb);
+      for (size_t k = 0; k < nfb; k++) {
+        d_fbtaps[k] = -fbtaps[k + 1];
+      }
+
+      if (nphase_taps != d_nphase_taps || nff != d_nff || nfb != d_nfb) {
+        d_nphase_taps = nphase_taps;
+        d_nff = nff;
+        d_nfb = nfb;
+        reset();
+      }
+    }
+
+    /*!
+     * \brief interpolate \p ninput samples into ninput * rate outputs
+     */
+    void interpolate(const i_type* input, o_type* output, size_t ninput)
+    {
+      for (size_t i = 0; i < ninput; i++) {
+        _push(d_prev_input, d_input_idx, d_nphase_taps, static_cast<tap_type>(input[i]));
+        const tap_type* x_hist = &d_prev_input[d_input_idx];
+
+        for (unsigned p = 0; p < d_rate; p++) {
+          // Feedforward: only the real input samples contribute
+          const tap_type* taps = &d_phase_taps[p * d_nphase_taps];
+          tap_type acc_ff = 0.0;
+          for (size_t j = 0; j < d_nphase_taps; j++) {
+            acc_ff += taps[j] * x_hist[j];
+          }
+          // Feedback at the output rate
+          const tap_type acc = _feedback(acc_ff, &d_prev_output[d_output_idx]);
+          _push(d_prev_output, d_output_idx, d_nfb, acc);
+          *output++ = static_cast<o_type>(acc);
+        }
+      }
+    }
+
+    /*!
+     * \brief decimate \p noutput * rate inputs into \p noutput samples
+     *
+     * Keeps the first sample of every group of rate inputs, like
+     * filtering every sample and keeping those where i % rate == 0.
+     */
+    void decimate(const i_type* input, o_type* output, size_t noutput)
+    {
+      // w(n) = x(n) - sum_{k>=1} fbtaps[k]*w(n-k)
+      // y(n) = sum_k fftaps[k]*w(n-k)
+      const size_t nstate = _nstate();
+      for (size_t o = 0; o < noutput; o++) {
+        // Kept phase
+        tap_type w = _feedback(static_cast<tap_type>(input[0]), &d_prev_output[d_output_idx]);
+        _push(d_prev_output, d_output_idx, nstate, w);
+        const tap_type* w_hist = &d_prev_output[d_output_idx];
+        tap_type acc = 0.0;
+        for (size_t k = 0; k < d_nff; k++) {
+          acc += d_fftaps[k] * w_hist[k];
+        }
+        *output++ = static_cast<o_type>(acc);
+
+        // Discarded phases only advance the recursion
+        for (unsigned p = 1; p < d_rate; p++) {
+          w = _feedback(static_cast<tap_type>(input[p]), &d_prev_output[d_output_idx]);
+          _push(d_prev_output, d_output_idx, nstate, w);
+        }
+        input += d_rate;
+      }
+    }
+
+    //! reset state to zero
+    void reset()
+    {
+      d_prev_input.assign(2 * std::max<size_t>(d_nphase_taps, 1), tap_type(0.0));
+      d_prev_output.assign(2 * std::max<size_t>(_nstate(), 1), tap_type(0.0));
+      d_input_idx = 0;
+      d_output_idx = 0;
+    }
+
+    //! true if \p other has as many taps, so that its state fits
+    bool same_order(const polyphase_iir_filter& other) const
+    {
+      return (d_rate == other.d_rate) && (d_nff == other.d_nff) && (d_nfb == other.d_nfb);
+    }
+
+    //! take over the state of \p other, which has the same_order()
+    void copy_state(const polyphase_iir_filter& other)
+    {
+      std::copy(other.d_prev_input.begin(), other.d_prev_input.end(), d_prev_input.begin());
+      std::copy(other.d_prev_output.begin(), other.d_prev_output.end(), d_prev_output.begin());
+      d_input_idx = other.d_input_idx;
+      d_output_idx = other.d_output_idx;
+    }
+
+    //! add \p offset to the feedback state
+    void offset_state(tap_type offset)
+    {
+      for (size_t i = 0; i < d_prev_output.size(); i++) {
+        d_prev_output[i] += offset;
+      }
+    }
+
+  protected:
+    // Length of the output history. decimate() keeps the direct form II
+    // state in it, which the feedforward taps also read.
+    size_t _nstate() const
+    {
+      return std::max(d_nff, d_nfb);
+    }
+
+    // Adds the feedback sum over the newest d_nfb outputs in y_hist to
+    // acc. The older terms are split over two partial sums and the
+    // most recent output, which was only just computed, is added last
+    // so that it sits at the end of a short dependency chain.
+    tap_type _feedback(tap_type acc, const tap_type* y_hist) const
+    {
+      if (d_nfb == 0) {
+        return acc;
+      }
+      tap_type acc_odd = 0.0;
+      size_t k = d_nfb - 1;
+      for (; k >= 2; k -= 2) {
+        acc     += d_fbtaps[k] * y_hist[k];
+        acc_odd += d_fbtaps[k - 1] * y_hist[k - 1];
+      }
+      if (k == 1) {
+        acc += d_fbtaps[1] * y_hist[1];
+      }
+      return (acc + acc_odd) + (d_fbtaps[0] * y_hist[0]);
+    }
+
+    // The history buffers hold every sample twice, len apart, so that
+    // the newest len samples are always contiguous starting at idx
+    // (newest first).
+    static void _push(std::vector<tap_type>& hist, size_t& idx, size_t len, tap_type val)
+    {
+      if (len == 0) return;
+      idx = (idx == 0) ? (len - 1) : (idx - 1);
+      hist[idx] = val;
+      hist[idx + len] = val;
+    }
+
+    const unsigned d_rate;
+    size_t d_nphase_taps;
+    size_t d_nff;
+    size_t d_nfb;
+    std::vector<tap_type> d_fftaps;
+    std::vector<tap_type> d_phase_taps;
+    std::vector<tap_type> d_fbtaps;
+    std::vector<tap_type> d_prev_input;
+    std::vector<tap_type> d_prev_output;
+    size_t d_input_idx;
+    size_t d_output_idx;
+  };
+
+  } /* namespace guitar */
+} /* namespace gr */
+
+#endif /* INCLUDED_POLYPHASE_IIR_FILTER_H */
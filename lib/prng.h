@@ -0,0 +1,73 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_PRNG_H
+#define INCLUDED_PRNG_H
+
+#include <stdint.h>
+#include <cstddef>
+
+namespace gr {
+  namespace guitar {
+
+  /*!
+   * \brief a small seedable pseudo-random number generator
+   *
+   * SplitMix64: a 64-bit counter run through a mixing function. Every
+   * seed, including 0, gives a full quality sequence, and the same seed
+   * gives the same sequence on every platform. Unlike rand() there is
+   * no global state, so each block instance draws from its own stream.
+   */
+  class prng
+  {
+  public:
+    explicit prng(uint64_t seed = 0): d_state(seed) {}
+
+    void seed(uint64_t seed) { d_state = seed; }
+
+    //! the next 64 random bits
+    uint64_t next()
+    {
+      uint64_t z = (d_state += 0x9E3779B97F4A7C15ULL);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      return z ^ (z >> 31);
+    }
+
+    //! uniform in [0, 1)
+    double uniform()
+    {
+      return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    //! uniform in [lo, hi]
+    size_t uniform_int(size_t lo, size_t hi)
+    {
+      return lo + static_cast<size_t>(next() % (uint64_t(hi - lo) + 1));
+    }
+
+  private:
+    uint64_t d_state;
+  };
+
+  } /* namespace guitar */
+} /* namespace gr */
+
+#endif /* INCLUDED_PRNG_H */
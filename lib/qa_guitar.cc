@@ -27,11 +27,15 @@
  */
 
 #include "qa_guitar.h"
+#include "qa_partitioned_convolver.h"
+#include "qa_reverb_kernel.h"
 
 CppUnit::TestSuite *
 qa_guitar::suite()
 {
   CppUnit::TestSuite *s = new CppUnit::TestSuite("guitar");
+  s->addTest(gr::guitar::qa_reverb_kernel::suite());
+  s->addTest(gr::guitar::qa_partitioned_convolver::suite());
 
   return s;
 }
@@ -0,0 +1,99 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "qa_partitioned_convolver.h"
+#include "partitioned_convolver.h"
+#include "prng.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace gr {
+  namespace guitar {
+
+    // Compares the convolver against direct convolution, for impulse
+    // responses from a single tap up to one that reaches the largest
+    // partitions, with the input fed in calls of random length
+    static void
+    check_against_direct(size_t first_partition)
+    {
+      const size_t ir_lens[] = { 1, 100, 3000, 40000 };
+      prng rng(first_partition);
+
+      for (size_t l = 0; l < sizeof(ir_lens) / sizeof(ir_lens[0]); l++) {
+        // Decaying noise, like a room response
+        std::vector<float> ir(ir_lens[l]);
+        for (size_t k = 0; k < ir.size(); k++) {
+          ir[k] = (rng.uniform() - 0.5) * std::exp(-3.0 * k / ir.size());
+        }
+        const size_t nsamps = ir.size() + 5000;
+        std::vector<float> in(nsamps), out(nsamps);
+        for (size_t i = 0; i < nsamps; i++) {
+          in[i] = rng.uniform() - 0.5;
+        }
+
+        partitioned_convolver conv(ir, first_partition);
+        CPPUNIT_ASSERT_EQUAL(first_partition, conv.latency());
+        for (size_t offset = 0; offset < nsamps; ) {
+          const size_t nitems = std::min(rng.uniform_int(1, 3000), nsamps - offset);
+          conv.process(&in[offset], &out[offset], nitems);
+          offset += nitems;
+        }
+
+        // The output lags by the latency. Long responses are checked on
+        // every 17th sample, which still lands on every partition phase.
+        const size_t stride = (ir.size() > 10000) ? 17 : 1;
+        double max_err = 0.0, max_ref = 0.0;
+        for (size_t t = first_partition; t < nsamps; t += stride) {
+          const size_t n = t - first_partition;
+          double ref = 0.0;
+          for (size_t k = 0; k <= std::min(n, ir.size() - 1); k++) {
+            ref += double(ir[k]) * in[n - k];
+          }
+          max_err = std::max(max_err, std::abs(ref - out[t]));
+          max_ref = std::max(max_ref, std::abs(ref));
+        }
+        for (size_t t = 0; t < first_partition; t++) {
+          CPPUNIT_ASSERT_EQUAL(0.0f, out[t]);
+        }
+        CPPUNIT_ASSERT(max_err <= 1e-5 * max_ref);
+      }
+    }
+
+    void
+    qa_partitioned_convolver::t_first_partition_2()
+    {
+      check_against_direct(2);
+    }
+
+    void
+    qa_partitioned_convolver::t_first_partition_64()
+    {
+      check_against_direct(64);
+    }
+
+    void
+    qa_partitioned_convolver::t_first_partition_1024()
+    {
+      check_against_direct(1024);
+    }
+
+  } /* namespace guitar */
+} /* namespace gr */
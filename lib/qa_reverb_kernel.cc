@@ -0,0 +1,80 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "qa_reverb_kernel.h"
+#include "prng.h"
+#include "reverb_kernel.h"
+#include <cmath>
+#include <vector>
+
+namespace gr {
+  namespace guitar {
+
+    // SNR in dB of the wet output of the single precision kernel, taking
+    // the double precision kernel on the same noise as the reference
+    static double
+    float_state_snr(size_t fdn_size)
+    {
+      std::vector<reverb_kernel::filt_config> comb_cfgs, allpass_cfgs;
+      prng rng;
+      reverb_kernel::design(44100.0, "P", "P", fdn_size, rng, comb_cfgs, allpass_cfgs);
+      reverb_kernel* kernel_d = reverb_kernel::make(44100.0, fdn_size, false);
+      reverb_kernel* kernel_f = reverb_kernel::make(44100.0, fdn_size, true);
+      kernel_d->configure(comb_cfgs, allpass_cfgs);
+      kernel_f->configure(comb_cfgs, allpass_cfgs);
+
+      // Long enough for the tail to build up, in blocks of odd sizes
+      const size_t nsamps = 1 << 18;
+      std::vector<float> in(nsamps), out_d(nsamps), out_f(nsamps);
+      for (size_t i = 0; i < nsamps; i++) {
+        in[i] = rng.uniform() - 0.5;
+      }
+      for (size_t offset = 0; offset < nsamps; ) {
+        const size_t nitems = std::min(rng.uniform_int(1, 3000), nsamps - offset);
+        kernel_d->process(&in[offset], &out_d[offset], nitems);
+        kernel_f->process(&in[offset], &out_f[offset], nitems);
+        offset += nitems;
+      }
+      delete kernel_d;
+      delete kernel_f;
+
+      double signal = 0.0, noise = 0.0;
+      for (size_t i = 0; i < nsamps; i++) {
+        const double err = static_cast<double>(out_d[i]) - out_f[i];
+        signal += static_cast<double>(out_d[i]) * out_d[i];
+        noise += err * err;
+      }
+      return 10.0 * std::log10(signal / noise);
+    }
+
+    void
+    qa_reverb_kernel::t_float_state_snr()
+    {
+      CPPUNIT_ASSERT(float_state_snr(0) > 120.0);
+    }
+
+    void
+    qa_reverb_kernel::t_float_state_snr_fdn()
+    {
+      CPPUNIT_ASSERT(float_state_snr(8) > 120.0);
+    }
+
+  } /* namespace guitar */
+} /* namespace gr */
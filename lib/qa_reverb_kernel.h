@@ -0,0 +1,46 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _QA_REVERB_KERNEL_H_
+#define _QA_REVERB_KERNEL_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+namespace gr {
+  namespace guitar {
+
+    class qa_reverb_kernel : public CppUnit::TestCase
+    {
+    public:
+      CPPUNIT_TEST_SUITE(qa_reverb_kernel);
+      CPPUNIT_TEST(t_float_state_snr);
+      CPPUNIT_TEST(t_float_state_snr_fdn);
+      CPPUNIT_TEST_SUITE_END();
+
+    private:
+      void t_float_state_snr();
+      void t_float_state_snr_fdn();
+    };
+
+  } /* namespace guitar */
+} /* namespace gr */
+
+#endif /* _QA_REVERB_KERNEL_H_ */
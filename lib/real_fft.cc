@@ -0,0 +1,162 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cmath>
+#include <stdexcept>
+#include "real_fft.h"
+
+#define PI  3.14159265358979323846
+
+namespace gr {
+  namespace guitar {
+
+    real_fft::real_fft(size_t size)
+      : d_size(size)
+    {
+      if (size < 4 || (size & (size - 1)) != 0) {
+        throw std::invalid_argument("real_fft: size must be a power of two, at least 4");
+      }
+      const size_t n = size / 2;
+
+      d_bitrev.resize(n);
+      size_t bits = 0;
+      while ((size_t(1) << bits) < n) bits++;
+      for (size_t i = 0; i < n; i++) {
+        size_t r = 0;
+        for (size_t b = 0; b < bits; b++) {
+          r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        d_bitrev[i] = r;
+      }
+
+      d_tw_re.resize(n);
+      d_tw_im.resize(n);
+      for (size_t h = 1; h < n; h <<= 1) {
+        for (size_t j = 0; j < h; j++) {
+          d_tw_re[h - 1 + j] = cos(-PI * j / h);
+          d_tw_im[h - 1 + j] = sin(-PI * j / h);
+        }
+      }
+
+      d_split_re.resize(n + 1);
+      d_split_im.resize(n + 1);
+      for (size_t k = 0; k <= n; k++) {
+        d_split_re[k] = cos(-2.0 * PI * k / size);
+        d_split_im[k] = sin(-2.0 * PI * k / size);
+      }
+
+      d_zre.resize(n);
+      d_zim.resize(n);
+    }
+
+    void
+    real_fft::_fft(float* re, float* im) const
+    {
+      const size_t n = d_size / 2;
+
+      for (size_t i = 0; i < n; i++) {
+        const size_t r = d_bitrev[i];
+        if (r > i) {
+          std::swap(re[i], re[r]);
+          std::swap(im[i], im[r]);
+        }
+      }
+
+      for (size_t h = 1; h < n; h <<= 1) {
+        const float* tw_re = &d_tw_re[h - 1];
+        const float* tw_im = &d_tw_im[h - 1];
+        for (size_t g = 0; g < n; g += 2 * h) {
+          float* a_re = re + g;
+          float* a_im = im + g;
+          float* b_re = a_re + h;
+          float* b_im = a_im + h;
+          for (size_t j = 0; j < h; j++) {
+            const float t_re = (b_re[j] * tw_re[j]) - (b_im[j] * tw_im[j]);
+            const float t_im = (b_re[j] * tw_im[j]) + (b_im[j] * tw_re[j]);
+            b_re[j] = a_re[j] - t_re;
+            b_im[j] = a_im[j] - t_im;
+            a_re[j] += t_re;
+            a_im[j] += t_im;
+          }
+        }
+      }
+    }
+
+    void
+    real_fft::forward(const float* in, float* re, float* im)
+    {
+      const size_t n = d_size / 2;
+      float* zre = &d_zre[0];
+      float* zim = &d_zim[0];
+
+      // Even samples in the real part, odd ones in the imaginary part
+      for (size_t i = 0; i < n; i++) {
+        zre[i] = in[2 * i];
+        zim[i] = in[(2 * i) + 1];
+      }
+      _fft(zre, zim);
+
+      // X[k] = E[k] + W^k O[k], where E and O are the transforms of
+      // the even and odd samples, recovered from Z[k] and Z[n-k]*
+      for (size_t k = 0; k <= n; k++) {
+        const float a_re = zre[k % n], a_im = zim[k % n];
+        const float b_re = zre[(n - k) % n], b_im = -zim[(n - k) % n];
+        const float e_re = 0.5f * (a_re + b_re), e_im = 0.5f * (a_im + b_im);
+        const float o_re = 0.5f * (a_im - b_im), o_im = -0.5f * (a_re - b_re);
+        re[k] = e_re + (d_split_re[k] * o_re) - (d_split_im[k] * o_im);
+        im[k] = e_im + (d_split_re[k] * o_im) + (d_split_im[k] * o_re);
+      }
+    }
+
+    void
+    real_fft::inverse(const float* re, const float* im, float* out)
+    {
+      const size_t n = d_size / 2;
+      float* zre = &d_zre[0];
+      float* zim = &d_zim[0];
+
+      // Z[k] = E[k] + i O[k], the inverse of the split in forward().
+      // Swapping the real and imaginary parts turns the forward
+      // transform into an inverse one.
+      for (size_t k = 0; k < n; k++) {
+        const float a_re = re[k], a_im = im[k];
+        const float b_re = re[n - k], b_im = -im[n - k];
+        const float e_re = a_re + b_re, e_im = a_im + b_im;
+        const float d_re = a_re - b_re, d_im = a_im - b_im;
+        // O[k] = (X[k] - X[n-k]*) * W^-k
+        const float o_re = (d_re * d_split_re[k]) + (d_im * d_split_im[k]);
+        const float o_im = (d_im * d_split_re[k]) - (d_re * d_split_im[k]);
+        zre[k] = e_re - o_im;
+        zim[k] = e_im + o_re;
+      }
+      _fft(zim, zre);
+
+      for (size_t i = 0; i < n; i++) {
+        out[2 * i] = zre[i];
+        out[(2 * i) + 1] = zim[i];
+      }
+    }
+
+  } /* namespace guitar */
+} /* namespace gr */
@@ -0,0 +1,68 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GUITAR_REAL_FFT_H
+#define INCLUDED_GUITAR_REAL_FFT_H
+
+#include <boost/noncopyable.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace gr {
+  namespace guitar {
+
+    //  Radix-2 FFT of a real signal, computed as a complex FFT of half
+    //  the size. Spectra are kept in split format (separate real and
+    //  imaginary arrays of size/2 + 1 bins) so that loops over the bins
+    //  vectorize.
+    //
+    //  Neither direction is normalized: inverse(forward(x)) is size * x.
+    class real_fft : boost::noncopyable
+    {
+     public:
+      //! size must be a power of two, at least 4
+      explicit real_fft(size_t size);
+
+      size_t size() const { return d_size; }
+
+      //! Transform size samples of in into size/2 + 1 bins
+      void forward(const float* in, float* re, float* im);
+
+      //! Transform size/2 + 1 bins into size samples of out
+      void inverse(const float* re, const float* im, float* out);
+
+     private:
+      // In-place complex FFT of size/2 points
+      void _fft(float* re, float* im) const;
+
+      const size_t d_size;
+      std::vector<size_t> d_bitrev;
+      // Butterfly twiddles, stage by stage: the stage with span h
+      // starts at index h - 1
+      std::vector<float> d_tw_re, d_tw_im;
+      // exp(-2*pi*i*k/size) for splitting the half size transform
+      std::vector<float> d_split_re, d_split_im;
+      std::vector<float> d_zre, d_zim;
+    };
+
+  } // namespace guitar
+} // namespace gr
+
+#endif /* INCLUDED_GUITAR_REAL_FFT_H */
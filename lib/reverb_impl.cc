@@ -23,6 +23,10 @@
 #endif
 
 #include <gnuradio/io_signature.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "denormal.h"
 #include "reverb_impl.h"
 
 namespace gr {
@@ -31,10 +35,12 @@ namespace gr {
     reverb::sptr
     reverb::make(bool enabled, double samp_rate,
         const std::string& comb_coeff_mode, const std::string& allpass_coeff_mode,
-        double wet_gamma)
+        double wet_gamma, int crossfade_len, bool single_precision, int fdn_size,
+        int seed, bool ring_out)
     {
       return gnuradio::get_initial_sptr
-        (new reverb_impl(enabled, samp_rate, comb_coeff_mode, allpass_coeff_mode, wet_gamma));
+        (new reverb_impl(enabled, samp_rate, comb_coeff_mode, allpass_coeff_mode, wet_gamma,
+          crossfade_len, single_precision, fdn_size, seed, ring_out));
     }
 
     /*
@@ -42,15 +48,25 @@ namespace gr {
      */
     reverb_impl::reverb_impl(bool enabled, double samp_rate,
         const std::string& comb_coeff_mode, const std::string& allpass_coeff_mode,
-        double wet_gamma)
+        double wet_gamma, int crossfade_len, bool single_precision, int fdn_size,
+        int seed, bool ring_out)
       : gr::sync_block("reverb",
         gr::io_signature::make(1, 1, sizeof(float)),
         gr::io_signature::make(1, 1, sizeof(float))),
-        d_samp_rate(samp_rate), d_enabled(enabled),
-        d_comb_coeff_mode(comb_coeff_mode), d_allpass_coeff_mode(allpass_coeff_mode),
-        d_wet_gamma(wet_gamma)
+        d_samp_rate(samp_rate), d_single_precision(single_precision),
+        d_fdn_size(fdn_size), d_bypass(enabled),
+        d_comb_coeff_mode(comb_coeff_mode), d_allpass_coeff_mode(allpass_coeff_mode), d_rng(seed),
+        d_wet_gamma(wet_gamma), d_crossfade_len(0), d_ring_out(ring_out),
+        d_kernel(NULL), d_old_kernel(NULL), d_fade_pos(0), d_fade_len(0), d_ringing(enabled),
+        d_cur_ring_out(ring_out)
     {
-      _recompute_filters();
+      setup_stats_port(this);
+      if (!reverb_kernel::valid_fdn_size(fdn_size)) {
+        throw std::invalid_argument("reverb: fdn_size must be 0, 4, 8 or 16");
+      }
+      set_crossfade_len(crossfade_len);
+      d_kernel = reverb_kernel::make(d_samp_rate, d_fdn_size, d_single_precision);
+      _configure(d_kernel);
     }
 
     /*
@@ -58,119 +74,178 @@ namespace gr {
      */
     reverb_impl::~reverb_impl()
     {
-      for (size_t i = 0; i < d_comb_filters.size(); i++) {
-        delete d_comb_filters[i];
-      }
-      for (size_t i = 0; i < d_allpass_filters.size(); i++) {
-        delete d_allpass_filters[i];
-      }
+      delete d_kernel;
+      delete d_old_kernel;
     }
 
     void
     reverb_impl::set_enabled(bool enabled)
     {
-      d_enabled = enabled;
+      d_bypass.set_enabled(enabled);
     }
 
     void
     reverb_impl::set_comb_coeff_mode(const std::string& comb_coeff_mode)
     {
       d_comb_coeff_mode = comb_coeff_mode;
-      d_changed = true;
+      _update_kernel();
     }
 
     void
     reverb_impl::set_allpass_coeff_mode(const std::string& allpass_coeff_mode)
     {
       d_allpass_coeff_mode = allpass_coeff_mode;
-      d_changed = true;
+      _update_kernel();
     }
 
     void
     reverb_impl::set_wet_gamma(double wet_gamma)
     {
-      d_wet_gamma = wet_gamma;
+      d_wet_gamma.set(wet_gamma);
+    }
+
+    void
+    reverb_impl::set_crossfade_len(int crossfade_len)
+    {
+      if (crossfade_len < 0) {
+        throw std::invalid_argument("reverb: crossfade_len must not be negative");
+      }
+      d_crossfade_len.set(crossfade_len);
     }
 
-    sparse_iir_filter<float,float,double>*
-    reverb_impl::_design_filter(const filt_config& cfg)
+    void
+    reverb_impl::set_ring_out(bool ring_out)
     {
-      const size_t num_taps = static_cast<size_t>(cfg.delay * d_samp_rate);
-      const double ff_first = (cfg.type == COMB) ? 0.0 : cfg.gain;
-      const double ff_last  = 1.0;
-      const double fb_last  = (cfg.type == COMB) ? -cfg.gain : cfg.gain;
-      return new sparse_iir_filter<float,float,double>(num_taps, ff_first, ff_last, fb_last);
+      d_ring_out.set(ring_out);
     }
 
     void
-    reverb_impl::_recompute_filters()
+    reverb_impl::_configure(reverb_kernel* kernel)
     {
-      for (size_t i = 0; i < d_comb_filters.size(); i++) {
-        delete d_comb_filters[i];
-      }
-      d_comb_filters.clear();
-      for (size_t i = 0; i < d_allpass_filters.size(); i++) {
-        delete d_allpass_filters[i];
+      std::vector<reverb_kernel::filt_config> comb_cfgs, allpass_cfgs;
+      reverb_kernel::design(d_samp_rate, d_comb_coeff_mode, d_allpass_coeff_mode, d_fdn_size,
+        d_rng, comb_cfgs, allpass_cfgs);
+      kernel->configure(comb_cfgs, allpass_cfgs);
+    }
+
+    // Runs in the caller's thread, so that the design and the clearing
+    // of the delay lines stay off the scheduler thread. Once work() has
+    // retired a kernel, reconfiguring does not allocate.
+    void
+    reverb_impl::_update_kernel()
+    {
+      reverb_kernel* kernel = d_new_kernels.reclaim();
+      if (kernel == NULL) {
+        kernel = reverb_kernel::make(d_samp_rate, d_fdn_size, d_single_precision);
       }
-      d_allpass_filters.clear();
+      _configure(kernel);
+      d_new_kernels.publish(kernel);
+    }
 
-      if (d_comb_coeff_mode == "P") {
-        d_comb_filters.push_back(   _design_filter(filt_config(COMB, 0.805, 0.0204)));
-        d_comb_filters.push_back(   _design_filter(filt_config(COMB, 0.827, 0.0176)));
-        d_comb_filters.push_back(   _design_filter(filt_config(COMB, 0.783, 0.0229)));
-        d_comb_filters.push_back(   _design_filter(filt_config(COMB, 0.764, 0.0254)));
+    void
+    reverb_impl::_swap_kernels()
+    {
+      // Finish the current crossfade before starting another one
+      if (d_old_kernel != NULL) {
+        return;
+      }
+      reverb_kernel* kernel = d_new_kernels.take();
+      if (kernel == NULL) {
+        return;
+      }
+      const int crossfade_len = d_crossfade_len.get();
+      if (crossfade_len > 0) {
+        d_old_kernel = d_kernel;
+        d_fade_pos = 0;
+        d_fade_len = crossfade_len;
       } else {
-        auto rand_gain = []() -> float {
-          return ((rand() / (float)RAND_MAX * 0.300) + 0.600);
-        };
-        auto rand_del = []() -> float {
-          return ((rand() / (float)RAND_MAX * 0.015) + 0.015);
-        };
-        d_comb_filters.push_back(   _design_filter(filt_config(COMB, rand_gain(), rand_del())));
-        d_comb_filters.push_back(   _design_filter(filt_config(COMB, rand_gain(), rand_del())));
-        d_comb_filters.push_back(   _design_filter(filt_config(COMB, rand_gain(), rand_del())));
-        d_comb_filters.push_back(   _design_filter(filt_config(COMB, rand_gain(), rand_del())));
+        d_new_kernels.retire(d_kernel);
       }
+      d_kernel = kernel;
+    }
 
-      if (d_allpass_coeff_mode == "P") {
-        d_allpass_filters.push_back(_design_filter(filt_config(ALLPASS, 0.700, 0.0028)));
-        d_allpass_filters.push_back(_design_filter(filt_config(ALLPASS, 0.700, 0.0009)));
-        d_allpass_filters.push_back(_design_filter(filt_config(ALLPASS, 0.700, 0.0003)));
-      } else {
-        auto rand_del = []() -> float {
-          return ((rand() / (float)RAND_MAX * 0.0100) + 0.0001);
-        };
-        d_allpass_filters.push_back(_design_filter(filt_config(ALLPASS, 0.700, rand_del())));
-        d_allpass_filters.push_back(_design_filter(filt_config(ALLPASS, 0.700, rand_del())));
-        d_allpass_filters.push_back(_design_filter(filt_config(ALLPASS, 0.700, rand_del())));
+    // Wet signal of n samples, fading out of d_old_kernel from fade_pos
+    void
+    reverb_impl::_process(const float* in, float* wet, size_t n, size_t fade_pos)
+    {
+      d_kernel->process(in, wet, n);
+      if (d_old_kernel != NULL && fade_pos < d_fade_len) {
+        const size_t nfade = std::min(n, d_fade_len - fade_pos);
+        d_old_kernel->crossfade_into(in, wet, nfade, fade_pos, d_fade_len);
       }
     }
 
+    void
+    reverb_impl::setup_rpc()
+    {
+      setup_stats_rpc(this);
+    }
+
     int
     reverb_impl::work(int noutput_items,
         gr_vector_const_void_star &input_items,
         gr_vector_void_star &output_items)
     {
-      if (d_changed) {
-        _recompute_filters();
-        d_changed = false;
-      }
+      work_stats::timer timer(*this, noutput_items);
+      denormal_guard guard;
+      _swap_kernels();
 
       const float *in = (const float *) input_items[0];
       float *out = (float *) output_items[0];
 
-      for (int i = 0; i < noutput_items; i++) {
-        double acc = 0.0;
-        // Parallel comb filters
-        for (int c = 0; c < d_comb_filters.size(); c++) {
-          acc += d_comb_filters[c]->filter(in[i]);
+      // Parameter snapshot for this buffer
+      bypass::fade fade;
+      const bypass::state_t state = d_bypass.snapshot(noutput_items, fade);
+      if (state == bypass::ACTIVE || (state == bypass::BYPASSED && !d_ringing)) {
+        d_cur_ring_out = d_ring_out.get();
+      }
+      const bool ring_out = d_cur_ring_out;
+      if (state == bypass::BYPASSED && !(ring_out && d_ringing)) {
+        d_ringing = false;
+        bypass::copy(in, out, noutput_items);
+        return noutput_items;
+      }
+      d_ringing = true;
+      smoothed_param<double>::ramp wet_gamma;
+      d_wet_gamma.snapshot(noutput_items, wet_gamma);
+
+      if (state == bypass::ACTIVE || !ring_out) {
+        // Compute the wet signal in place in the output buffer
+        _process(in, out, noutput_items, d_fade_pos);
+        for (int i = 0; i < noutput_items; i++) {
+          const double g = wet_gamma.at(i);
+          out[i] = (g * out[i]) + ((1.0 - g) * in[i]);
+        }
+        if (state == bypass::FADING) {
+          fade.crossfade(in, out, noutput_items);
+        }
+      } else {
+        // Ringing out: the input of the reverb fades instead of its
+        // output, and the dry signal stays at unity
+        float faded[bypass::CHUNK_SIZE];
+        float peak = 0.0f;
+        for (int offset = 0; offset < noutput_items; offset += bypass::CHUNK_SIZE) {
+          const int nitems = std::min<int>(bypass::CHUNK_SIZE, noutput_items - offset);
+          fade.fade_input(in + offset, faded, nitems, offset);
+          _process(faded, out + offset, nitems, d_fade_pos + offset);
+          for (int i = 0; i < nitems; i++) {
+            const double g = wet_gamma.at(offset + i);
+            const float wet = out[offset + i];
+            peak = std::max(peak, std::abs(wet));
+            out[offset + i] = (g * (wet - faded[i])) + in[offset + i];
+          }
         }
-        // Serial allpass filters
-        for (int a = 0; a < d_allpass_filters.size(); a++) {
-          acc += d_allpass_filters[a]->filter(acc);
+        if (state == bypass::BYPASSED && bypass::tail_done(peak)) {
+          d_ringing = false;
+        }
+      }
+
+      if (d_old_kernel != NULL) {
+        d_fade_pos += std::min<size_t>(noutput_items, d_fade_len - d_fade_pos);
+        if (d_fade_pos == d_fade_len) {
+          d_new_kernels.retire(d_old_kernel);
+          d_old_kernel = NULL;
         }
-        float wet = static_cast<float>(acc);
-        out[i] = d_enabled ? ((d_wet_gamma * wet) + ((1.0 - d_wet_gamma) * in[i])) : in[i];
       }
 
       return noutput_items;
@@ -178,4 +253,3 @@ namespace gr {
 
   } /* namespace guitar */
 } /* namespace gr */
-
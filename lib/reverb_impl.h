@@ -22,60 +22,74 @@
 #define INCLUDED_GUITAR_REVERB_IMPL_H
 
 #include <guitar/reverb.h>
-#include "sparse_iir_filter.h"
+#include "bypass.h"
+#include "handoff.h"
+#include "param.h"
+#include "prng.h"
+#include "reverb_kernel.h"
+#include "work_stats.h"
 
 namespace gr {
   namespace guitar {
 
-    class reverb_impl : public reverb
+    class reverb_impl : public reverb, public work_stats
     {
      private:
-      // Types
-      enum filt_type { COMB, ALLPASS };
-
-      struct filt_config {
-        filt_config(filt_type type_, double gain_, double delay_):
-          type(type_), gain(gain_), delay(delay_) {}
-
-        filt_type type;
-        double gain;
-        double delay;
-      };
-
       // Parameters
       const double d_samp_rate;
-      double d_enabled;
+      const bool d_single_precision;
+      const int d_fdn_size;
+      bypass d_bypass;
       std::string d_comb_coeff_mode;
       std::string d_allpass_coeff_mode;
-      double d_wet_gamma;
-      bool d_changed;
+      prng d_rng;
+      smoothed_param<double> d_wet_gamma;
+      param<int> d_crossfade_len;
+      param<bool> d_ring_out;
 
-      // Filters
-      std::vector< sparse_iir_filter<float,float,double>* > d_comb_filters;
-      std::vector< sparse_iir_filter<float,float,double>* > d_allpass_filters;
+      // Kernels configured by the setters, on their way to work().
+      // Kernels that work() is done with are reused.
+      handoff<reverb_kernel> d_new_kernels;
 
-      sparse_iir_filter<float,float,double>* _design_filter(const filt_config& cfg);
-      void _recompute_filters();
+      // Filters. Owned by work(). While d_old_kernel is set the
+      // output fades from it to d_kernel.
+      reverb_kernel* d_kernel;
+      reverb_kernel* d_old_kernel;
+      size_t d_fade_pos;
+      size_t d_fade_len;
+      // Set while the tail is still audible
+      bool d_ringing;
+      // The ring_out in effect. Only follows d_ring_out while no fade
+      // or tail is under way, so a change can not cut a tail short.
+      bool d_cur_ring_out;
+
+      void _configure(reverb_kernel* kernel);
+      void _update_kernel();
+      void _swap_kernels();
+      void _process(const float* in, float* wet, size_t n, size_t fade_pos);
 
      public:
       reverb_impl(bool enabled, double samp_rate,
           const std::string& comb_coeff_mode, const std::string& allpass_coeff_mode,
-          double wet_gamma);
+          double wet_gamma, int crossfade_len, bool single_precision, int fdn_size,
+          int seed, bool ring_out);
       ~reverb_impl();
 
       // Where all the action really happens
       int work(int noutput_items,
          gr_vector_const_void_star &input_items,
          gr_vector_void_star &output_items);
+      void setup_rpc();
 
       void set_enabled(bool enabled);
       void set_comb_coeff_mode(const std::string& comb_coeff_mode);
       void set_allpass_coeff_mode(const std::string& allpass_coeff_mode);
       void set_wet_gamma(double wet_gamma);
+      void set_crossfade_len(int crossfade_len);
+      void set_ring_out(bool ring_out);
     };
 
   } // namespace guitar
 } // namespace gr
 
 #endif /* INCLUDED_GUITAR_REVERB_IMPL_H */
-
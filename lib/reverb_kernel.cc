@@ -0,0 +1,454 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "denormal.h"
+#include "reverb_kernel.h"
+
+namespace gr {
+  namespace guitar {
+
+    const size_t reverb_kernel::CHUNK_SIZE;
+
+    // Upper ends of the randomized ranges in design(), which are above
+    // every profile delay
+    const double reverb_kernel::MAX_COMB_DELAY = 0.030;
+    const double reverb_kernel::MAX_ALLPASS_DELAY = 0.0101;
+    const double reverb_kernel::MAX_FDN_DELAY = 0.045;
+
+    // Feedback delay network lines are attenuated for a decay to
+    // -60 dB in FDN_RT60 seconds
+    static const double FDN_RT60 = 1.0;
+
+    // Delays (samples) of the profiles and of the randomized ranges at
+    // one sample rate
+    struct delay_preset {
+      double samp_rate;
+      size_t comb_delays[reverb_kernel::NUM_COMBS];
+      size_t allpass_delays[reverb_kernel::NUM_ALLPASSES];
+      size_t fdn4_delays[4];
+      size_t fdn8_delays[8];
+      size_t fdn16_delays[16];
+      size_t comb_range[2];
+      size_t allpass_range[2];
+      size_t fdn_range[2];
+    };
+
+    // Profile delays in seconds. Combs and allpasses get
+    // floor(delay * samp_rate) - 1 samples. The network lines are
+    // spread geometrically over [FDN_MIN_DELAY, FDN_MAX_DELAY] and
+    // rounded down to a prime, so that lines rarely share echoes.
+    static const double COMB_DELAYS[reverb_kernel::NUM_COMBS] = { 0.0204, 0.0176, 0.0229, 0.0254 };
+    static const double COMB_GAINS[reverb_kernel::NUM_COMBS] = { 0.805, 0.827, 0.783, 0.764 };
+    static const double ALLPASS_DELAYS[reverb_kernel::NUM_ALLPASSES] = { 0.0028, 0.0009, 0.0003 };
+    static const double ALLPASS_GAIN = 0.700;
+    static const double FDN_MIN_DELAY = 0.0211;
+    static const double FDN_MAX_DELAY = 0.0437;
+
+    // The delays of the common sample rates, precomputed with
+    // _compute_preset() so that design() has nothing to convert
+    static const delay_preset PRESETS[] = {
+      { 44100.0,
+        { 898, 775, 1008, 1119 }, { 122, 38, 12 },
+        { 929, 1181, 1511, 1913 },
+        { 929, 1031, 1129, 1259, 1409, 1559, 1733, 1913 },
+        { 929, 971, 1021, 1069, 1129, 1181, 1237, 1307,
+          1367, 1439, 1511, 1583, 1663, 1747, 1831, 1913 },
+        { 660, 1322 }, { 3, 444 }, { 661, 1984 } },
+      { 48000.0,
+        { 978, 843, 1098, 1218 }, { 133, 42, 13 },
+        { 1009, 1289, 1637, 2089 },
+        { 1009, 1123, 1237, 1381, 1531, 1699, 1889, 2089 },
+        { 1009, 1063, 1109, 1171, 1229, 1289, 1327, 1409,
+          1493, 1567, 1637, 1723, 1811, 1901, 1997, 2089 },
+        { 719, 1439 }, { 3, 483 }, { 720, 2160 } },
+      { 88200.0,
+        { 1798, 1551, 2018, 2239 }, { 245, 78, 25 },
+        { 1861, 2371, 3023, 3853 },
+        { 1861, 2063, 2287, 2539, 2819, 3121, 3469, 3853 },
+        { 1861, 1951, 2039, 2143, 2251, 2371, 2477, 2609,
+          2741, 2879, 3023, 3169, 3331, 3491, 3671, 3853 },
+        { 1322, 2645 }, { 7, 889 }, { 1323, 3969 } },
+      { 96000.0,
+        { 1957, 1688, 2197, 2437 }, { 267, 85, 27 },
+        { 2017, 2579, 3271, 4177 },
+        { 2017, 2243, 2477, 2767, 3067, 3407, 3779, 4177 },
+        { 2017, 2113, 2221, 2341, 2459, 2579, 2707, 2843,
+          2971, 3121, 3271, 3449, 3623, 3803, 3989, 4177 },
+        { 1439, 2879 }, { 8, 968 }, { 1440, 4320 } },
+    };
+
+    // Largest prime not above n
+    static size_t
+    _prime_below(size_t n)
+    {
+      for (; n > 2; n--) {
+        bool prime = true;
+        for (size_t f = 2; (f * f) <= n && prime; f++) {
+          prime = (n % f) != 0;
+        }
+        if (prime) {
+          break;
+        }
+      }
+      return n;
+    }
+
+    // Delay of a comb or allpass filter of delay seconds
+    static size_t
+    _filt_delay(double samp_rate, double delay)
+    {
+      const size_t num_taps = static_cast<size_t>(delay * samp_rate);
+      return (num_taps > 1) ? (num_taps - 1) : 1;
+    }
+
+    static void
+    _fdn_delays(double samp_rate, size_t fdn_size, size_t* delays)
+    {
+      for (size_t l = 0; l < fdn_size; l++) {
+        const double delay = FDN_MIN_DELAY * pow(FDN_MAX_DELAY / FDN_MIN_DELAY, l / (fdn_size - 1.0));
+        delays[l] = _prime_below(static_cast<size_t>(delay * samp_rate));
+      }
+    }
+
+    // The delays for sample rates without a precomputed preset
+    static void
+    _compute_preset(double samp_rate, delay_preset& p)
+    {
+      p.samp_rate = samp_rate;
+      for (size_t c = 0; c < reverb_kernel::NUM_COMBS; c++) {
+        p.comb_delays[c] = _filt_delay(samp_rate, COMB_DELAYS[c]);
+      }
+      for (size_t a = 0; a < reverb_kernel::NUM_ALLPASSES; a++) {
+        p.allpass_delays[a] = _filt_delay(samp_rate, ALLPASS_DELAYS[a]);
+      }
+      _fdn_delays(samp_rate, 4, p.fdn4_delays);
+      _fdn_delays(samp_rate, 8, p.fdn8_delays);
+      _fdn_delays(samp_rate, 16, p.fdn16_delays);
+      p.comb_range[0] = _filt_delay(samp_rate, 0.015);
+      p.comb_range[1] = _filt_delay(samp_rate, reverb_kernel::MAX_COMB_DELAY);
+      p.allpass_range[0] = _filt_delay(samp_rate, 0.0001);
+      p.allpass_range[1] = _filt_delay(samp_rate, reverb_kernel::MAX_ALLPASS_DELAY);
+      p.fdn_range[0] = static_cast<size_t>(0.015 * samp_rate);
+      p.fdn_range[1] = static_cast<size_t>(reverb_kernel::MAX_FDN_DELAY * samp_rate);
+    }
+
+    bool
+    reverb_kernel::valid_fdn_size(int fdn_size)
+    {
+      return fdn_size == 0 || fdn_size == 4 || fdn_size == 8 || fdn_size == 16;
+    }
+
+    void
+    reverb_kernel::design(double samp_rate, const std::string& comb_coeff_mode,
+        const std::string& allpass_coeff_mode, size_t fdn_size, prng& rng,
+        std::vector<filt_config>& comb_cfgs,
+        std::vector<filt_config>& allpass_cfgs)
+    {
+      comb_cfgs.clear();
+      allpass_cfgs.clear();
+
+      delay_preset computed;
+      const delay_preset* p = NULL;
+      for (size_t i = 0; i < sizeof(PRESETS) / sizeof(PRESETS[0]); i++) {
+        if (PRESETS[i].samp_rate == samp_rate) {
+          p = &PRESETS[i];
+        }
+      }
+      if (p == NULL) {
+        _compute_preset(samp_rate, computed);
+        p = &computed;
+      }
+
+      if (fdn_size > 0) {
+        const size_t* fdn_delays = (fdn_size == 4) ? p->fdn4_delays :
+                                   (fdn_size == 8) ? p->fdn8_delays : p->fdn16_delays;
+        for (size_t l = 0; l < fdn_size; l++) {
+          const size_t delay = (comb_coeff_mode == "P") ? fdn_delays[l] :
+            _prime_below(rng.uniform_int(p->fdn_range[0], p->fdn_range[1]));
+          const double gain = pow(10.0, -3.0 * delay / (samp_rate * FDN_RT60));
+          comb_cfgs.push_back(filt_config(COMB, gain, delay));
+        }
+      } else if (comb_coeff_mode == "P") {
+        for (size_t c = 0; c < NUM_COMBS; c++) {
+          comb_cfgs.push_back(filt_config(COMB, COMB_GAINS[c], p->comb_delays[c]));
+        }
+      } else {
+        for (size_t c = 0; c < NUM_COMBS; c++) {
+          const double gain = (rng.uniform() * 0.300) + 0.600;
+          comb_cfgs.push_back(filt_config(COMB, gain,
+            rng.uniform_int(p->comb_range[0], p->comb_range[1])));
+        }
+      }
+
+      for (size_t a = 0; a < NUM_ALLPASSES; a++) {
+        const size_t delay = (allpass_coeff_mode == "P") ? p->allpass_delays[a] :
+          rng.uniform_int(p->allpass_range[0], p->allpass_range[1]);
+        allpass_cfgs.push_back(filt_config(ALLPASS, ALLPASS_GAIN, delay));
+      }
+    }
+
+    size_t
+    reverb_kernel::_num_taps(double samp_rate, double delay)
+    {
+      return static_cast<size_t>(delay * samp_rate);
+    }
+
+    //  The kernel for one precision of the filter state and one kind
+    //  of bank in front of the allpass filters
+    template<class state_type, class bank_type>
+    class reverb_kernel_impl : public reverb_kernel
+    {
+     public:
+      static size_t storage_size(double samp_rate)
+      {
+        size_t nbytes = bank_type::storage_size(_max_bank_delay(samp_rate));
+        nbytes += NUM_ALLPASSES * sparse_iir_filter<float,float,state_type>::storage_size(
+          _num_taps(samp_rate, MAX_ALLPASS_DELAY));
+        return nbytes;
+      }
+
+      reverb_kernel_impl(double samp_rate, void* storage)
+        : d_bank(NULL), d_num_allpasses(0)
+      {
+        if (storage == NULL) {
+          d_owned_storage.resize(storage_size(samp_rate) + STORAGE_ALIGN - 1);
+          storage = align_storage(&d_owned_storage[0]);
+        }
+        char* arena = static_cast<char*>(storage);
+
+        // Parallel comb filters: y(n) = x(n-D) - g*y(n-D), or the
+        // feedback delay network
+        const size_t max_delay = _max_bank_delay(samp_rate);
+        d_bank = new bank_type(max_delay, arena);
+        arena += bank_type::storage_size(max_delay);
+
+        // Serial allpass filters: y(n) = g*x(n) + x(n-D) + g*y(n-D)
+        const size_t allpass_taps = _num_taps(samp_rate, MAX_ALLPASS_DELAY);
+        for (size_t a = 0; a < NUM_ALLPASSES; a++) {
+          d_allpass_filters.push_back(
+            new sparse_iir_filter<float,float,state_type>(allpass_taps, 0.0, 1.0, 0.0, arena));
+          arena += sparse_iir_filter<float,float,state_type>::storage_size(allpass_taps);
+        }
+      }
+
+      ~reverb_kernel_impl()
+      {
+        delete d_bank;
+        for (size_t i = 0; i < d_allpass_filters.size(); i++) {
+          delete d_allpass_filters[i];
+        }
+      }
+
+      void configure(const std::vector<filt_config>& comb_cfgs,
+          const std::vector<filt_config>& allpass_cfgs)
+      {
+        if (allpass_cfgs.size() > NUM_ALLPASSES) {
+          throw std::invalid_argument("reverb: Too many allpass filters");
+        }
+        _configure_bank(d_bank, comb_cfgs);
+
+        d_num_allpasses = allpass_cfgs.size();
+        for (size_t a = 0; a < d_num_allpasses; a++) {
+          const state_type gain = allpass_cfgs[a].gain;
+          d_allpass_filters[a]->set_taps(gain, 1.0, gain);
+          d_allpass_filters[a]->set_num_taps(allpass_cfgs[a].delay + 1);
+        }
+
+        reset();
+      }
+
+      void process(const float* in, float* wet, size_t n)
+      {
+        float tmp[CHUNK_SIZE];
+
+        // Parallel comb filters or feedback delay network
+#ifdef GUITAR_DENORMAL_OFFSET
+        // The delay lines are too long to offset their state, so the
+        // offset goes into their input
+        const float denormal = d_denormal.next();
+        for (size_t offset = 0; offset < n; offset += CHUNK_SIZE) {
+          const size_t nitems = std::min<size_t>(CHUNK_SIZE, n - offset);
+          for (size_t i = 0; i < nitems; i++) {
+            tmp[i] = in[offset + i] + denormal;
+          }
+          d_bank->filter_n(tmp, wet + offset, nitems);
+        }
+#else
+        d_bank->filter_n(in, wet, n);
+#endif
+
+        // Serial allpass filters
+        for (size_t offset = 0; offset < n; offset += CHUNK_SIZE) {
+          const size_t nitems = std::min<size_t>(CHUNK_SIZE, n - offset);
+          float* chunk = wet + offset;
+          for (size_t a = 0; a < d_num_allpasses; a++) {
+            d_allpass_filters[a]->filter_n(chunk, tmp, nitems);
+            for (size_t i = 0; i < nitems; i++) {
+              chunk[i] += tmp[i];
+            }
+          }
+        }
+      }
+
+      void reset()
+      {
+        d_bank->reset();
+        for (size_t i = 0; i < d_allpass_filters.size(); i++) {
+          d_allpass_filters[i]->reset();
+        }
+      }
+
+     private:
+      static size_t _max_bank_delay(double samp_rate)
+      {
+        const size_t num_taps = _num_taps(samp_rate, _max_delay((bank_type*)NULL));
+        return (num_taps > 1) ? (num_taps - 1) : 1;
+      }
+
+      static double _max_delay(comb_bank<state_type, NUM_COMBS>*)
+      {
+        return MAX_COMB_DELAY;
+      }
+
+      template<size_t N>
+      static double _max_delay(feedback_delay_network<state_type, N>*)
+      {
+        return MAX_FDN_DELAY;
+      }
+
+      // Unused combs are silenced
+      void _configure_bank(comb_bank<state_type, NUM_COMBS>* bank,
+          const std::vector<filt_config>& comb_cfgs)
+      {
+        if (comb_cfgs.size() > NUM_COMBS) {
+          throw std::invalid_argument("reverb: Too many comb filters");
+        }
+        for (size_t c = 0; c < NUM_COMBS; c++) {
+          if (c < comb_cfgs.size()) {
+            bank->set_taps(c, comb_cfgs[c].delay, 1.0, -comb_cfgs[c].gain);
+          } else {
+            bank->set_taps(c, 1, 0.0, 0.0);
+          }
+        }
+      }
+
+      // Unused lines are silenced
+      template<size_t N>
+      void _configure_bank(feedback_delay_network<state_type, N>* bank,
+          const std::vector<filt_config>& line_cfgs)
+      {
+        if (line_cfgs.size() > N) {
+          throw std::invalid_argument("reverb: Too many delay lines");
+        }
+        for (size_t l = 0; l < N; l++) {
+          if (l < line_cfgs.size()) {
+            bank->set_line(l, line_cfgs[l].delay, line_cfgs[l].gain);
+          } else {
+            bank->set_line(l, 1, 0.0);
+          }
+        }
+      }
+
+      std::vector<char> d_owned_storage;
+      bank_type* d_bank;
+      std::vector< sparse_iir_filter<float,float,state_type>* > d_allpass_filters;
+      size_t d_num_allpasses;
+#ifdef GUITAR_DENORMAL_OFFSET
+      denormal_offset d_denormal;
+#endif
+    };
+
+    template<class state_type>
+    static size_t
+    _storage_size(double samp_rate, size_t fdn_size)
+    {
+      switch (fdn_size) {
+        case 4:
+          return reverb_kernel_impl<state_type, feedback_delay_network<state_type, 4> >::storage_size(samp_rate);
+        case 8:
+          return reverb_kernel_impl<state_type, feedback_delay_network<state_type, 8> >::storage_size(samp_rate);
+        case 16:
+          return reverb_kernel_impl<state_type, feedback_delay_network<state_type, 16> >::storage_size(samp_rate);
+        default:
+          return reverb_kernel_impl<state_type, comb_bank<state_type, reverb_kernel::NUM_COMBS> >::storage_size(samp_rate);
+      }
+    }
+
+    template<class state_type>
+    static reverb_kernel*
+    _make(double samp_rate, size_t fdn_size, void* storage)
+    {
+      switch (fdn_size) {
+        case 4:
+          return new reverb_kernel_impl<state_type, feedback_delay_network<state_type, 4> >(samp_rate, storage);
+        case 8:
+          return new reverb_kernel_impl<state_type, feedback_delay_network<state_type, 8> >(samp_rate, storage);
+        case 16:
+          return new reverb_kernel_impl<state_type, feedback_delay_network<state_type, 16> >(samp_rate, storage);
+        default:
+          return new reverb_kernel_impl<state_type, comb_bank<state_type, reverb_kernel::NUM_COMBS> >(samp_rate, storage);
+      }
+    }
+
+    size_t
+    reverb_kernel::storage_size(double samp_rate, size_t fdn_size, bool single_precision)
+    {
+      return single_precision ? _storage_size<float>(samp_rate, fdn_size)
+                              : _storage_size<double>(samp_rate, fdn_size);
+    }
+
+    reverb_kernel*
+    reverb_kernel::make(double samp_rate, size_t fdn_size, bool single_precision, void* storage)
+    {
+      if (!valid_fdn_size(fdn_size)) {
+        throw std::invalid_argument("reverb: fdn_size must be 0, 4, 8 or 16");
+      }
+      if (single_precision) {
+        return _make<float>(samp_rate, fdn_size, storage);
+      }
+      return _make<double>(samp_rate, fdn_size, storage);
+    }
+
+    void
+    reverb_kernel::crossfade_into(const float* in, float* wet, size_t n,
+        size_t fade_pos, size_t fade_len)
+    {
+      float tmp[CHUNK_SIZE];
+      const double inv_len = 1.0 / fade_len;
+
+      for (size_t offset = 0; offset < n; offset += CHUNK_SIZE) {
+        const size_t nitems = std::min<size_t>(CHUNK_SIZE, n - offset);
+        process(in + offset, tmp, nitems);
+        for (size_t i = 0; i < nitems; i++) {
+          const double gain = (fade_pos + offset + i + 1) * inv_len;
+          wet[offset + i] = (gain * wet[offset + i]) + ((1.0 - gain) * tmp[i]);
+        }
+      }
+    }
+
+  } /* namespace guitar */
+} /* namespace gr */
@@ -0,0 +1,134 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GUITAR_REVERB_KERNEL_H
+#define INCLUDED_GUITAR_REVERB_KERNEL_H
+
+#include <boost/noncopyable.hpp>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "sparse_iir_filter.h"
+#include "comb_bank.h"
+#include "feedback_delay_network.h"
+#include "prng.h"
+
+namespace gr {
+  namespace guitar {
+
+    //  The reverb kernel computes the wet output of a single channel
+    //  using a Schroeder reverberator: a bank of parallel comb filters
+    //  followed by a chain of serial allpass filters. With a non-zero
+    //  fdn_size the comb bank is replaced by a feedback delay network
+    //  of that many lines, which gives a denser and smoother tail for
+    //  a cost that grows with N log N.
+    //
+    //  All comb and allpass delay lines are carved out of one block of
+    //  storage_size() bytes, which is either owned by the kernel or
+    //  provided by the caller so that many kernels can share an arena.
+    //  The block is sized for the longest delays that design() can
+    //  produce in any mode, so configure() can install any design
+    //  without allocating.
+    //
+    //  The filter state is kept in double precision, or in single
+    //  precision if the kernel is made with single_precision, which
+    //  halves the footprint of the comb and allpass output delay lines.
+    class reverb_kernel : boost::noncopyable
+    {
+     public:
+      enum filt_type { COMB, ALLPASS };
+
+      struct filt_config {
+        filt_config(filt_type type_, double gain_, size_t delay_):
+          type(type_), gain(gain_), delay(delay_) {}
+
+        filt_type type;
+        double gain;
+        size_t delay;   // Samples
+      };
+
+      static const size_t NUM_COMBS = 4;
+      static const size_t NUM_ALLPASSES = 3;
+
+      //! Longest delays (seconds) that design() produces in any mode
+      static const double MAX_COMB_DELAY;
+      static const double MAX_ALLPASS_DELAY;
+      static const double MAX_FDN_DELAY;
+
+      //! Whether \p fdn_size is 0 (comb bank) or a supported network size
+      static bool valid_fdn_size(int fdn_size);
+
+      //! Fill comb_cfgs and allpass_cfgs for the given coefficient modes.
+      //! For a feedback delay network, comb_cfgs holds its fdn_size lines.
+      //! Randomized modes draw from \p rng, so the same seed always
+      //! gives the same design.
+      static void design(double samp_rate, const std::string& comb_coeff_mode,
+          const std::string& allpass_coeff_mode, size_t fdn_size, prng& rng,
+          std::vector<filt_config>& comb_cfgs,
+          std::vector<filt_config>& allpass_cfgs);
+
+      //! Bytes of delay line storage needed by a kernel. A multiple
+      //! of STORAGE_ALIGN, so kernels can be packed back to back.
+      static size_t storage_size(double samp_rate, size_t fdn_size = 0,
+          bool single_precision = false);
+
+      //! Alignment of the storage passed to the constructor
+      static const size_t STORAGE_ALIGN = 64;
+
+      //! Round \p p up to STORAGE_ALIGN
+      static char* align_storage(char* p)
+      {
+        const uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<char*>((addr + STORAGE_ALIGN - 1) & ~(uintptr_t)(STORAGE_ALIGN - 1));
+      }
+
+      //! A new kernel with its delay lines in \p storage of at least
+      //! storage_size() bytes, or in memory of its own if NULL
+      static reverb_kernel* make(double samp_rate, size_t fdn_size = 0,
+          bool single_precision = false, void* storage = NULL);
+      virtual ~reverb_kernel() {}
+
+      //! Install the given filters and clear the delay lines. Delays
+      //! are clamped to the maximum. Throws if there are too many filters.
+      virtual void configure(const std::vector<filt_config>& comb_cfgs,
+          const std::vector<filt_config>& allpass_cfgs) = 0;
+
+      //! Compute n samples of the wet signal. in and wet may alias.
+      virtual void process(const float* in, float* wet, size_t n) = 0;
+
+      //! Fade out of this kernel into wet, which holds the output of
+      //! the kernel replacing it. Sample i gets weight
+      //! 1 - (fade_pos + i + 1) / fade_len; n must not run past fade_len.
+      void crossfade_into(const float* in, float* wet, size_t n,
+          size_t fade_pos, size_t fade_len);
+
+      //! Clear all delay lines
+      virtual void reset() = 0;
+
+     protected:
+      static const size_t CHUNK_SIZE = 256;
+
+      static size_t _num_taps(double samp_rate, double delay);
+    };
+
+  } // namespace guitar
+} // namespace gr
+
+#endif /* INCLUDED_GUITAR_REVERB_KERNEL_H */
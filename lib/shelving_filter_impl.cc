@@ -23,34 +23,37 @@
 #endif
 
 #include <gnuradio/io_signature.h>
+#include <algorithm>
 #include "shelving_filter_impl.h"
 
-#define PI  3.14159265358979323846
-
 namespace gr {
   namespace guitar {
 
     shelving_filter::sptr
-    shelving_filter::make(double samp_rate, std::string type, double gain, double cutoff_freq)
+    shelving_filter::make(double samp_rate, std::string type, double gain, double cutoff_freq,
+        int ramp_len)
     {
       return gnuradio::get_initial_sptr
-        (new shelving_filter_impl(samp_rate, type, gain, cutoff_freq));
+        (new shelving_filter_impl(samp_rate, type, gain, cutoff_freq, ramp_len));
     }
 
     /*
      * The private constructor
      */
-    shelving_filter_impl::shelving_filter_impl(double samp_rate, std::string type, double gain, double cutoff_freq)
+    shelving_filter_impl::shelving_filter_impl(double samp_rate, std::string type, double gain, double cutoff_freq,
+        int ramp_len)
       : gr::sync_block("shelving_filter",
         gr::io_signature::make(1, 1, sizeof(float)),
         gr::io_signature::make(1, 1, sizeof(float))),
         d_samp_rate(samp_rate),
-        d_type(type), d_gain(gain), d_cutoff_freq(cutoff_freq),
-        d_b0(1.0), d_b1(0.0), d_b2(0.0),
-        d_a1(0.0), d_a2(0.0),
+        d_type(type), d_gain(gain), d_cutoff_freq(cutoff_freq), d_ramp_len(0),
+        d_ramp_left(0),
         d_z1(0.0), d_z2(0.0)
     {
-      _design_sos_filter(d_type, d_gain, d_cutoff_freq);
+      setup_stats_port(this);
+      set_ramp_len(ramp_len);
+      d_coeffs = _design_sos_filter(d_type, d_gain, d_cutoff_freq);
+      d_target = d_coeffs;
     }
 
     /*
@@ -62,23 +65,31 @@ namespace gr {
 
     void
     shelving_filter_impl::set_type(const std::string& type) {
-      _design_sos_filter(type, d_gain, d_cutoff_freq);
+      _publish(_design_sos_filter(type, d_gain, d_cutoff_freq));
       d_type = type;
     }
 
     void
     shelving_filter_impl::set_gain(const double& gain) {
-      _design_sos_filter(d_type, gain, d_cutoff_freq);
+      _publish(_design_sos_filter(d_type, gain, d_cutoff_freq));
       d_gain = gain;
     }
 
     void
     shelving_filter_impl::set_cutoff_freq(const double& cutoff_freq) {
-      _design_sos_filter(d_type, d_gain, cutoff_freq);
+      _publish(_design_sos_filter(d_type, d_gain, cutoff_freq));
       d_cutoff_freq = cutoff_freq;
     }
 
     void
+    shelving_filter_impl::set_ramp_len(int ramp_len) {
+      if (ramp_len < 0) {
+        throw std::invalid_argument("shelving_filter: ramp_len must not be negative");
+      }
+      d_ramp_len = ramp_len;
+    }
+
+    biquad::coeffs
     shelving_filter_impl::_design_sos_filter(std::string type,
         double gain,
         double cutoff_freq)
@@ -97,48 +108,86 @@ namespace gr {
         throw std::invalid_argument("shelving_filter: Invalid filter type. Must be in {low-shelf, high-shelf}");
       }
 
-      // Resonance
-      double Q = 1 / sqrt(2);
-      double Q_inv = 1 / Q;
-
-      double K = tan(PI * (cutoff_freq/d_samp_rate));
-      double K_sq = K * K;
-      double V0 = pow(10.0, (gain / 20));
-      if (V0 < 1) V0 = 1/V0;  // Invert gain if a cut
-
-      if (low_shelf) {
-        if (gain >= 0.0) {
-          // Bass boost
-          d_b0 = (1 + sqrt(V0)*Q_inv*K + V0*K_sq) / (1 + Q_inv*K + K_sq);
-          d_b1 = (2 * (V0*K_sq - 1) ) / (1 + Q_inv*K + K_sq);
-          d_b2 = (1 - sqrt(V0)*Q_inv*K + V0*K_sq) / (1 + Q_inv*K + K_sq);
-          d_a1 = (2 * (K_sq - 1) ) / (1 + Q_inv*K + K_sq);
-          d_a2 = (1 - Q_inv*K + K_sq) / (1 + Q_inv*K + K_sq);
-        } else {
-          // Bass cut
-          d_b0 = (1 + Q_inv*K + K_sq) / (1 + Q_inv*sqrt(V0) *K + V0*K_sq);
-          d_b1 = (2 * (K_sq - 1) ) / (1 + Q_inv*sqrt(V0) *K + V0*K_sq);
-          d_b2 = (1 - Q_inv*K + K_sq) / (1 + Q_inv*sqrt(V0) *K + V0*K_sq);
-          d_a1 = (2 * (V0*K_sq - 1) ) / (1 + Q_inv*sqrt(V0) *K + V0*K_sq);
-          d_a2 = (1 - Q_inv*sqrt(V0) *K + V0*K_sq) / (1 + Q_inv*sqrt(V0) *K + V0*K_sq);
-        }
-      } else {
-        if (gain > 0 && !low_shelf) {
-          // Treble boost
-          d_b0 = (V0 + Q_inv*sqrt(V0) *K + K_sq) / (1 + Q_inv*K + K_sq);
-          d_b1 = (2 * (K_sq - V0) ) / (1 + Q_inv*K + K_sq);
-          d_b2 = (V0 - Q_inv*sqrt(V0) *K + K_sq) / (1 + Q_inv*K + K_sq);
-          d_a1 = (2 * (K_sq - 1) ) / (1 + Q_inv*K + K_sq);
-          d_a2 = (1 - Q_inv*K + K_sq) / (1 + Q_inv*K + K_sq);
-        } else {
-          // Treble cut
-          d_b0 = (1 + Q_inv*K + K_sq) / (V0 + Q_inv*sqrt(V0) *K + K_sq);
-          d_b1 = (2 * (K_sq - 1) ) / (V0 + Q_inv*sqrt(V0) *K + K_sq);
-          d_b2 = (1 - Q_inv*K + K_sq) / (V0 + Q_inv*sqrt(V0) *K + K_sq);
-          d_a1 = (2 * ((K_sq)/V0 - 1) ) / (1 + Q_inv/sqrt(V0) *K + (K_sq)/V0);
-          d_a2 = (1 - Q_inv/sqrt(V0) *K + (K_sq)/V0) / (1 + Q_inv/sqrt(V0) *K + (K_sq)/V0);
-        }
+      return biquad::design(low_shelf ? biquad::LOW_SHELF : biquad::HIGH_SHELF,
+        d_samp_rate, gain, cutoff_freq, 1 / sqrt(2));
+    }
+
+    void
+    shelving_filter_impl::_publish(const biquad::coeffs& coeffs)
+    {
+      coeff_update update;
+      update.coeffs = coeffs;
+      update.ramp_len = d_ramp_len;
+      d_updates.write(update);
+    }
+
+    void
+    shelving_filter_impl::_start_ramp(const coeff_update& update)
+    {
+      d_target = update.coeffs;
+      if (update.ramp_len == 0) {
+        d_coeffs = d_target;
+        d_ramp_left = 0;
+        return;
+      }
+      // Ramp from wherever the coefficients are now, which may be
+      // part way through an earlier ramp. The set of stable (a1, a2)
+      // is convex, so every point on the way is stable too.
+      const double inv_len = 1.0 / update.ramp_len;
+      d_step.b0 = (d_target.b0 - d_coeffs.b0) * inv_len;
+      d_step.b1 = (d_target.b1 - d_coeffs.b1) * inv_len;
+      d_step.b2 = (d_target.b2 - d_coeffs.b2) * inv_len;
+      d_step.a1 = (d_target.a1 - d_coeffs.a1) * inv_len;
+      d_step.a2 = (d_target.a2 - d_coeffs.a2) * inv_len;
+      d_ramp_left = update.ramp_len;
+    }
+
+    void
+    shelving_filter_impl::_filter(const float* in, float* out, int nitems)
+    {
+      const biquad::coeffs c = d_coeffs;
+      double z1 = d_z1, z2 = d_z2;
+      for (int i = 0; i < nitems; i++) {
+        // Compute SOS filter using using the
+        // transposed direct form II representation
+        out[i] = z1 + (in[i] * c.b0);
+        z1 = z2 + (in[i] * c.b1) - (out[i] * c.a1);
+        z2 = (in[i] * c.b2) - (out[i] * c.a2);
       }
+      d_z1 = z1;
+      d_z2 = z2;
+    }
+
+    void
+    shelving_filter_impl::_filter_ramp(const float* in, float* out, int nitems)
+    {
+      biquad::coeffs c = d_coeffs;
+      const biquad::coeffs step = d_step;
+      double z1 = d_z1, z2 = d_z2;
+      for (int i = 0; i < nitems; i++) {
+        c.b0 += step.b0;
+        c.b1 += step.b1;
+        c.b2 += step.b2;
+        c.a1 += step.a1;
+        c.a2 += step.a2;
+        out[i] = z1 + (in[i] * c.b0);
+        z1 = z2 + (in[i] * c.b1) - (out[i] * c.a1);
+        z2 = (in[i] * c.b2) - (out[i] * c.a2);
+      }
+      d_z1 = z1;
+      d_z2 = z2;
+      d_coeffs = c;
+      d_ramp_left -= nitems;
+      if (d_ramp_left == 0) {
+        // Land exactly on the target rather than on the summed steps
+        d_coeffs = d_target;
+      }
+    }
+
+    void
+    shelving_filter_impl::setup_rpc()
+    {
+      setup_stats_rpc(this);
     }
 
     int
@@ -146,16 +195,25 @@ namespace gr {
         gr_vector_const_void_star &input_items,
         gr_vector_void_star &output_items)
     {
+      work_stats::timer timer(*this, noutput_items);
+      denormal_guard guard;
       const float *in = (const float *) input_items[0];
       float *out = (float *) output_items[0];
 
-      for (int i = 0; i < noutput_items; i++) {
-        // Compute SOS filter using using the
-        // transposed direct form II representation
-        out[i] = d_z1 + (in[i] * d_b0);
-        d_z1 = d_z2 + (in[i] * d_b1) - (out[i] * d_a1);
-        d_z2 = (in[i] * d_b2) - (out[i] * d_a2);
+      coeff_update update;
+      if (d_updates.read(update)) {
+        _start_ramp(update);
       }
+#ifdef GUITAR_DENORMAL_OFFSET
+      d_z1 += d_denormal.next();
+#endif
+
+      int nramp = 0;
+      if (d_ramp_left > 0) {
+        nramp = std::min(noutput_items, d_ramp_left);
+        _filter_ramp(in, out, nramp);
+      }
+      _filter(in + nramp, out + nramp, noutput_items - nramp);
 
       // Tell runtime system how many output items we produced.
       return noutput_items;
@@ -163,4 +221,3 @@ namespace gr {
 
   } /* namespace guitar */
 } /* namespace gr */
-
@@ -22,39 +22,65 @@
 #define INCLUDED_GUITAR_SHELVING_FILTER_IMPL_H
 
 #include <guitar/shelving_filter.h>
+#include "biquad.h"
+#include "denormal.h"
+#include "triple_buffer.h"
+#include "work_stats.h"
 
 namespace gr {
   namespace guitar {
 
-    class shelving_filter_impl : public shelving_filter
+    class shelving_filter_impl : public shelving_filter, public work_stats
     {
     private:
-      // Filter parameters
+      struct coeff_update {
+        biquad::coeffs coeffs;
+        int ramp_len;
+      };
+
+      // Filter parameters. Owned by the controller thread.
       const double d_samp_rate;
       std::string d_type;
       double d_gain;
       double d_cutoff_freq;
+      int d_ramp_len;
+
+      // Coefficients in flight from the setters to work()
+      triple_buffer<coeff_update> d_updates;
 
-      double d_b0, d_b1, d_b2;  // Feedforward coefficients
-      double d_a1, d_a2;        // Feedback coefficients
+      // Owned by work()
+      biquad::coeffs d_coeffs;
+      biquad::coeffs d_target;
+      biquad::coeffs d_step;
+      int d_ramp_left;
       double d_z1, d_z2;        // Delay line
+#ifdef GUITAR_DENORMAL_OFFSET
+      denormal_offset d_denormal;
+#endif
 
-      void _design_sos_filter(std::string type,
+      biquad::coeffs _design_sos_filter(std::string type,
           double gain,
           double cutoff_freq);
+      void _publish(const biquad::coeffs& coeffs);
+      void _start_ramp(const coeff_update& update);
+      void _filter(const float* in, float* out, int nitems);
+      void _filter_ramp(const float* in, float* out, int nitems);
 
     public:
-      shelving_filter_impl(double samp_rate, std::string type, double gain, double cutoff_freq);
+      shelving_filter_impl(double samp_rate, std::string type, double gain, double cutoff_freq,
+          int ramp_len);
       ~shelving_filter_impl();
 
       virtual void set_type(const std::string& type);
       virtual void set_gain(const double& gain);
       virtual void set_cutoff_freq(const double& cutoff_freq);
+      virtual void set_ramp_len(int ramp_len);
 
       // Where all the action really happens
       int work(int noutput_items,
          gr_vector_const_void_star &input_items,
          gr_vector_void_star &output_items);
+      void setup_rpc();
     };
 
   } // namespace guitar
@@ -0,0 +1,36 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_SIMD_H
+#define INCLUDED_SIMD_H
+
+// GCC and clang vector extensions, for kernels that hold a few filters
+// side by side in one register
+#if defined(__GNUC__) && !defined(__INTEL_COMPILER)
+#define GUITAR_HAVE_VECTOR_EXT 1
+#endif
+
+// x86 builds add AVX variants of those kernels next to the baseline
+// ones and pick one at runtime with __builtin_cpu_supports("avx")
+#if defined(GUITAR_HAVE_VECTOR_EXT) && (defined(__x86_64__) || defined(__i386__))
+#define GUITAR_HAVE_AVX_DISPATCH 1
+#endif
+
+#endif /* INCLUDED_SIMD_H */
@@ -21,48 +21,124 @@
 #ifndef INCLUDED_SPARSE_IIR_FILTER_H
 #define INCLUDED_SPARSE_IIR_FILTER_H
 
-#include <boost/circular_buffer.hpp>
+#include <boost/noncopyable.hpp>
+#include <algorithm>
+#include <vector>
 
 namespace gr {
   namespace guitar {
 
   /*!
    * \brief class template for single pole IIR filter
+   *
+   * The delay lines are flat arrays with a power-of-two length so that
+   * wraparound is a single mask. Because the only taps are at lag 0 and
+   * lag D, any run of up to D samples depends only on history written
+   * before the run started, which lets filter_n() process whole runs
+   * in a tight loop with no per-sample branching.
+   *
+   * The delay lines are either owned by the filter or carved out of
+   * caller-provided memory of at least storage_size() bytes, which
+   * lets many filters share a single arena.
    */
   template<class o_type, class i_type, class tap_type>
-  class sparse_iir_filter
+  class sparse_iir_filter : boost::noncopyable
   {
   public:
     /*!
      * \brief construct new sparse IIR with given taps
      *
      * computes y(n) = x(n)*ff_first + x(n-D)*ff_last + y(n-D)*fb_last
+     * where D = num_taps - 1
+     *
+     * \param storage memory of at least storage_size(num_taps) bytes
+     *        for the delay lines, or NULL to allocate internally.
      */
     sparse_iir_filter(size_t num_taps,
-      tap_type ff_first = 1.0, tap_type ff_last = 0.0, tap_type fb_last = 0.0):
-        d_prev_input(num_taps - 1), d_prev_output(num_taps - 1),
+      tap_type ff_first = 1.0, tap_type ff_last = 0.0, tap_type fb_last = 0.0,
+      void* storage = NULL):
+        d_delay((num_taps > 1) ? (num_taps - 1) : 1),
+        d_mask(_next_pow2(d_delay) - 1),
+        d_wr_idx(0),
         d_ff_first(ff_first), d_ff_last(ff_last), d_fb_last(fb_last)
     {
+      if (storage == NULL) {
+        d_owned_storage.resize(storage_size(num_taps));
+        storage = &d_owned_storage[0];
+      }
+      d_prev_output = static_cast<tap_type*>(storage);
+      d_prev_input = reinterpret_cast<i_type*>(
+        static_cast<char*>(storage) + _align((d_mask + 1) * sizeof(tap_type)));
       reset();
     }
 
+    //! bytes of delay line storage needed by a filter with \p num_taps taps
+    static size_t storage_size(size_t num_taps)
+    {
+      const size_t buff_len = _next_pow2((num_taps > 1) ? (num_taps - 1) : 1);
+      return _align(buff_len * sizeof(tap_type)) + _align(buff_len * sizeof(i_type));
+    }
+
     /*!
      * \brief compute a single output value.
      * \returns the filtered input value.
      */
     o_type filter(const i_type input)
     {
+      const size_t rd_idx = (d_wr_idx - d_delay) & d_mask;
       // Accumulate partial sums
-      tap_type output = d_fb_last * d_prev_output.front();
+      tap_type output = d_fb_last * d_prev_output[rd_idx];
       output += d_ff_first * static_cast<tap_type>(input);
-      output += d_ff_last * static_cast<tap_type>(d_prev_input.front());
+      output += d_ff_last * static_cast<tap_type>(d_prev_input[rd_idx]);
       // Update delay lines
-      d_prev_input.push_back(input);
-      d_prev_output.push_back(output);
+      d_prev_input[d_wr_idx] = input;
+      d_prev_output[d_wr_idx] = output;
+      d_wr_idx = (d_wr_idx + 1) & d_mask;
       // Output value
       return static_cast<o_type>(output);
     }
 
+    /*!
+     * \brief compute \p n output values.
+     *
+     * Equivalent to calling filter() \p n times. \p input and
+     * \p output may point to the same buffer.
+     */
+    void filter_n(const i_type* input, o_type* output, size_t n)
+    {
+      const tap_type ff_first = d_ff_first;
+      const tap_type ff_last  = d_ff_last;
+      const tap_type fb_last  = d_fb_last;
+      const size_t   buff_len = d_mask + 1;
+
+      while (n > 0) {
+        const size_t rd_idx = (d_wr_idx - d_delay) & d_mask;
+        // Longest run that wraps neither pointer and never reads
+        // a value written within the same run
+        size_t run = std::min(n, d_delay);
+        run = std::min(run, buff_len - rd_idx);
+        run = std::min(run, buff_len - d_wr_idx);
+
+        const i_type*   x_rd = &d_prev_input[rd_idx];
+        const tap_type* y_rd = &d_prev_output[rd_idx];
+        i_type*         x_wr = &d_prev_input[d_wr_idx];
+        tap_type*       y_wr = &d_prev_output[d_wr_idx];
+        for (size_t i = 0; i < run; i++) {
+          const i_type x = input[i];
+          const tap_type y = (fb_last * y_rd[i]) + (ff_first * static_cast<tap_type>(x)) +
+                             (ff_last * static_cast<tap_type>(x_rd[i]));
+          x_wr[i] = x;
+          y_wr[i] = y;
+          output[i] = static_cast<o_type>(y);
+        }
+
+        d_wr_idx = (d_wr_idx + run) & d_mask;
+        input += run;
+        output += run;
+        n -= run;
+      }
+    }
+
     /*!
      * \brief install \p alpha as the current taps.
      */
@@ -73,18 +149,49 @@ namespace gr {
       d_fb_last  = fb_last;
     }
 
+    /*!
+     * \brief change the delay to that of a filter with \p num_taps taps
+     *
+     * Does not allocate: the delay is clamped to what fits the delay
+     * lines allocated at construction. Resets the state.
+     */
+    void set_num_taps(size_t num_taps)
+    {
+      d_delay = std::min((num_taps > 1) ? (num_taps - 1) : 1, d_mask + 1);
+      reset();
+    }
+
+    //! the sparse delay D in samples
+    size_t delay() const { return d_delay; }
+
     //! reset state to zero
     void reset()
     {
-      for (size_t i = 0; i < d_prev_input.capacity(); i++) {
-        d_prev_input.push_back(tap_type(0.0));
-        d_prev_output.push_back(tap_type(0.0));
-      }
+      std::fill(d_prev_input, d_prev_input + d_mask + 1, i_type(0.0));
+      std::fill(d_prev_output, d_prev_output + d_mask + 1, tap_type(0.0));
+      d_wr_idx = 0;
     }
 
   protected:
-    boost::circular_buffer<i_type>   d_prev_input;
-    boost::circular_buffer<tap_type> d_prev_output;
+    static size_t _next_pow2(size_t n)
+    {
+      size_t p = 1;
+      while (p < n) p <<= 1;
+      return p;
+    }
+
+    // Round up to a cache line so that every delay line is aligned
+    static size_t _align(size_t n)
+    {
+      return (n + 63) & ~static_cast<size_t>(63);
+    }
+
+    size_t d_delay;
+    const size_t d_mask;
+    std::vector<char> d_owned_storage;
+    i_type*   d_prev_input;
+    tap_type* d_prev_output;
+    size_t    d_wr_idx;
     tap_type  d_ff_first, d_ff_last, d_fb_last;
   };
 
@@ -0,0 +1,87 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_TRIPLE_BUFFER_H
+#define INCLUDED_TRIPLE_BUFFER_H
+
+#include <atomic>
+
+namespace gr {
+  namespace guitar {
+
+  /*!
+   * \brief lock-free mailbox that hands the latest value from one
+   * writer thread to one reader thread
+   *
+   * The writer fills a private slot and swaps it with the shared
+   * middle slot; the reader swaps its own slot with the middle one
+   * when a new value is pending. Neither side ever touches a slot the
+   * other one owns, so a value is always read whole, and neither side
+   * waits. Intermediate values written between two reads are dropped.
+   *
+   * Typical use is a block setter (writer) handing parameters to
+   * work() (reader).
+   */
+  template<class T>
+  class triple_buffer
+  {
+  public:
+    explicit triple_buffer(const T& init = T()):
+      d_middle(1), d_write(0), d_read(2)
+    {
+      d_slots[0] = d_slots[1] = d_slots[2] = init;
+    }
+
+    //! publish \p val. Writer thread only.
+    void write(const T& val)
+    {
+      d_slots[d_write] = val;
+      d_write = d_middle.exchange(d_write | PENDING, std::memory_order_acq_rel) & INDEX;
+    }
+
+    /*!
+     * \brief take the latest value if one was published since the
+     * last call. Reader thread only.
+     * \returns true and sets \p val if there was a new value
+     */
+    bool read(T& val)
+    {
+      if (!(d_middle.load(std::memory_order_relaxed) & PENDING)) {
+        return false;
+      }
+      d_read = d_middle.exchange(d_read, std::memory_order_acq_rel) & INDEX;
+      val = d_slots[d_read];
+      return true;
+    }
+
+  private:
+    static const int INDEX   = 0x3;
+    static const int PENDING = 0x4;
+
+    T d_slots[3];
+    std::atomic<int> d_middle;   // Shared slot index, plus PENDING
+    int d_write;                 // Owned by the writer
+    int d_read;                  // Owned by the reader
+  };
+
+  } /* namespace guitar */
+} /* namespace gr */
+
+#endif /* INCLUDED_TRIPLE_BUFFER_H */
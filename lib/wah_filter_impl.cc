@@ -23,6 +23,7 @@
 #endif
 
 #include <gnuradio/io_signature.h>
+#include <algorithm>
 #include "wah_filter_impl.h"
 
 #define PI  3.14159265358979323846
@@ -37,10 +38,11 @@ namespace gr {
         double cutoff_freq_min,
         double cutoff_freq_max,
         double lfo_freq,
-        double damp)
+        double damp,
+        int control_period)
     {
       return gnuradio::get_initial_sptr
-        (new wah_filter_impl(enabled, samp_rate, envelope_src, cutoff_freq_min, cutoff_freq_max, lfo_freq, damp));
+        (new wah_filter_impl(enabled, samp_rate, envelope_src, cutoff_freq_min, cutoff_freq_max, lfo_freq, damp, control_period));
     }
 
     /*
@@ -52,17 +54,21 @@ namespace gr {
         double cutoff_freq_min,
         double cutoff_freq_max,
         double lfo_freq,
-        double damp)
+        double damp,
+        int control_period)
       : gr::sync_block("wah_filter",
         gr::io_signature::make(1, 2, sizeof(float)),
         gr::io_signature::make(1, 1, sizeof(float))),
         d_samp_rate(samp_rate), d_use_sidechain(envelope_src == "S"),
-        d_enabled(enabled),
+        d_bypass(enabled),
         d_cutoff_freq_min(cutoff_freq_min), d_cutoff_freq_max(cutoff_freq_max),
-        d_lfo_freq(lfo_freq), d_damp(damp),
+        d_lfo_freq(lfo_freq), d_damp(damp), d_control_period(1),
         d_y_lp(0.0), d_y_bp(0.0), d_y_hp(0.0),
-        d_lfo_phase(0.0)
+        d_lfo(samp_rate, lfo_freq)
     {
+      setup_stats_port(this);
+      set_control_period(control_period);
+      d_fval = _gen_svf_fval(cutoff_freq_min, cutoff_freq_max, d_use_sidechain ? 0.0 : 0.5);
     }
 
     /*
@@ -75,71 +81,125 @@ namespace gr {
     void
     wah_filter_impl::set_enabled(double enabled)
     {
-      d_enabled = enabled;
+      d_bypass.set_enabled(enabled);
     }
 
     void
     wah_filter_impl::set_cutoff_freq_min(double cutoff_freq_min)
     {
-      d_cutoff_freq_min = cutoff_freq_min;
+      d_cutoff_freq_min.set(cutoff_freq_min);
     }
 
     void
     wah_filter_impl::set_cutoff_freq_max(double cutoff_freq_max)
     {
-      d_cutoff_freq_max = cutoff_freq_max;
+      d_cutoff_freq_max.set(cutoff_freq_max);
     }
 
     void
     wah_filter_impl::set_lfo_freq(double lfo_freq)
     {
-      d_lfo_freq = lfo_freq;
+      d_lfo_freq.set(lfo_freq);
     }
 
     void
     wah_filter_impl::set_damp(double damp)
     {
-      d_damp = damp;
+      d_damp.set(damp);
+    }
+
+    void
+    wah_filter_impl::set_control_period(int control_period)
+    {
+      d_control_period.set(std::max(control_period, 1));
     }
 
     double
-    wah_filter_impl::_gen_lfo_next()
+    wah_filter_impl::_gen_lfo_next(int nsamps)
     {
-      d_lfo_phase += (2 * PI) / d_samp_rate;
-      double lfo_val = 0.5 + (0.5 * sin(d_lfo_phase * d_lfo_freq));
-      if (d_lfo_phase > (2 * PI) / d_lfo_freq) {
-        d_lfo_phase = 0;
-      }
-      return lfo_val;
+      return 0.5 + (0.5 * d_lfo.advance(nsamps));
     }
 
     double
-    wah_filter_impl::_gen_svf_fval(double envelope)
+    wah_filter_impl::_gen_svf_fval(double freq_min, double freq_max, double envelope)
     {
-      double curr_freq = d_cutoff_freq_min + ((d_cutoff_freq_max - d_cutoff_freq_min) * envelope);
+      double curr_freq = freq_min + ((freq_max - freq_min) * envelope);
       return 2 * sin((PI * curr_freq) / d_samp_rate);
     }
 
+    bool
+    wah_filter_impl::check_topology(int ninputs, int noutputs)
+    {
+      return !d_use_sidechain || (ninputs > 1);
+    }
+
+    void
+    wah_filter_impl::setup_rpc()
+    {
+      setup_stats_rpc(this);
+    }
+
     int
     wah_filter_impl::work(int noutput_items,
         gr_vector_const_void_star &input_items,
         gr_vector_void_star &output_items)
     {
+      work_stats::timer timer(*this, noutput_items);
+      denormal_guard guard;
       const float *in = (const float *) input_items[0];
-      const float *sc = (const float *) input_items[1];
+      // The sidechain input is only connected in sidechain mode, and
+      // check_topology() makes sure it is connected then
+      const float *sc = (input_items.size() > 1) ? (const float *) input_items[1] : NULL;
       float *out = (float *) output_items[0];
 
-      double Qval = d_damp / sqrt(2);
+      bypass::fade fade;
+      const bypass::state_t state = d_bypass.snapshot(noutput_items, fade);
+      if (state == bypass::BYPASSED) {
+        bypass::copy(in, out, noutput_items);
+        return noutput_items;
+      }
+
+      // Parameter snapshot for this buffer
+      const double freq_min = d_cutoff_freq_min.get();
+      const double freq_max = d_cutoff_freq_max.get();
+      const double Qval = d_damp.get() / sqrt(2);
+      const int control_period = d_control_period.get();
+      d_lfo.set_freq(d_lfo_freq.get());
+
+      double y_lp = d_y_lp, y_bp = d_y_bp, y_hp = d_y_hp;
+#ifdef GUITAR_DENORMAL_OFFSET
+      const double denormal = d_denormal.next();
+      y_lp += denormal;
+      y_bp += denormal;
+#endif
+
+      for (int offset = 0; offset < noutput_items; offset += control_period) {
+        const int nitems = std::min(control_period, noutput_items - offset);
+
+        // Control rate: evaluate F at the end of this run and ramp to it
+        const double envelope = d_use_sidechain ? sc[offset + nitems - 1] : _gen_lfo_next(nitems);
+        const double Fend = _gen_svf_fval(freq_min, freq_max, envelope);
+        const double Fstep = (Fend - d_fval) / nitems;
+        double Fval = d_fval;
+
+        // Audio rate
+        for (int i = offset; i < (offset + nitems); i++) {
+          Fval += Fstep;
+          y_hp = in[i] - y_lp - (Qval * y_bp);
+          y_bp = (Fval * y_hp) + y_bp;
+          y_lp = (Fval * y_bp) + y_lp;
+          // Output is the bandpass + lowpass output of the SVF
+          out[i] = static_cast<float>((y_bp + y_lp) / 2.0);
+        }
+        d_fval = Fend;
+      }
 
-      for (int i = 0; i < noutput_items; i++) {
-        double envelope = d_use_sidechain ? sc[i] : _gen_lfo_next();
-        double Fval = _gen_svf_fval(envelope);
+      d_y_lp = y_lp;
+      d_y_bp = y_bp;
+      d_y_hp = y_hp;
 
-        d_y_hp = in[i] - d_y_lp - (Qval * d_y_bp);
-        d_y_bp = (Fval * d_y_hp) + d_y_bp;
-        d_y_lp = (Fval * d_y_bp) + d_y_lp;
-        // Output is the bandpass + lowpass output of the SVF
-        out[i] = d_enabled ? static_cast<float>((d_y_bp + d_y_lp) / 2.0) : in[i];
+      if (state == bypass::FADING) {
+        fade.crossfade(in, out, noutput_items);
       }
 
       return noutput_items;
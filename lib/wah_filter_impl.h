@@ -22,6 +22,11 @@
 #define INCLUDED_GUITAR_WAH_FILTER_IMPL_H
 
 #include <guitar/wah_filter.h>
+#include "bypass.h"
+#include "denormal.h"
+#include "lfo.h"
+#include "param.h"
+#include "work_stats.h"
 
 namespace gr {
   namespace guitar {
@@ -44,22 +49,32 @@ namespace gr {
     //  %
     //  Now, f_cutoff varies with time so the values of F vary with time
     //  based on the F = 2*sin(pi*f_cutoff/f_samp) model.
-    class wah_filter_impl : public wah_filter
+    //
+    //  F is only evaluated at the control rate, i.e. at the end of every
+    //  run of control_period samples, and is ramped linearly from its
+    //  previous value over the run. The SVF recursion itself runs at
+    //  the audio rate without any transcendental calls.
+    class wah_filter_impl : public wah_filter, public work_stats
     {
      private:
       const double d_samp_rate;
       const bool d_use_sidechain;
-      double d_enabled;
-      double d_cutoff_freq_min;
-      double d_cutoff_freq_max;
-      double d_lfo_freq;
-      double d_damp;
+      bypass d_bypass;
+      param<double> d_cutoff_freq_min;
+      param<double> d_cutoff_freq_max;
+      param<double> d_lfo_freq;
+      param<double> d_damp;
+      param<int> d_control_period;
 
       double d_y_lp, d_y_bp, d_y_hp;
-      double d_lfo_phase;
+#ifdef GUITAR_DENORMAL_OFFSET
+      denormal_offset d_denormal;
+#endif
+      lfo d_lfo;
+      double d_fval;
 
-      double _gen_lfo_next();
-      double _gen_svf_fval(double envelope);
+      double _gen_lfo_next(int nsamps);
+      double _gen_svf_fval(double freq_min, double freq_max, double envelope);
 
      public:
       wah_filter_impl(bool enabled,
@@ -68,7 +83,8 @@ namespace gr {
           double cutoff_freq_min,
           double cutoff_freq_max,
           double lfo_freq,
-          double damp);
+          double damp,
+          int control_period);
       ~wah_filter_impl();
 
       void set_enabled(double enabled);
@@ -76,11 +92,16 @@ namespace gr {
       void set_cutoff_freq_max(double cutoff_freq_max);
       void set_lfo_freq(double lfo_freq);
       void set_damp(double damp);
+      void set_control_period(int control_period);
+
+      // The sidechain envelope needs the second input
+      bool check_topology(int ninputs, int noutputs);
 
       // Where all the action really happens
       int work(int noutput_items,
          gr_vector_const_void_star &input_items,
          gr_vector_void_star &output_items);
+      void setup_rpc();
     };
 
   } // namespace guitar
@@ -0,0 +1,131 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include "wav_file.h"
+
+namespace gr {
+  namespace guitar {
+
+    static const uint16_t FORMAT_PCM = 0x0001;
+    static const uint16_t FORMAT_IEEE_FLOAT = 0x0003;
+    static const uint16_t FORMAT_EXTENSIBLE = 0xFFFE;
+
+    static uint16_t
+    _le16(const unsigned char* p)
+    {
+      return p[0] | (p[1] << 8);
+    }
+
+    static uint32_t
+    _le32(const unsigned char* p)
+    {
+      return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+    }
+
+    // One sample of the given format, scaled to [-1, 1]
+    static float
+    _sample(const unsigned char* p, uint16_t format, uint16_t bits)
+    {
+      if (format == FORMAT_IEEE_FLOAT) {
+        const uint32_t u = _le32(p);
+        float f;
+        memcpy(&f, &u, sizeof(f));
+        return f;
+      }
+      switch (bits) {
+        case 8:
+          return (p[0] - 128) / 128.0f;
+        case 16:
+          return int16_t(_le16(p)) / 32768.0f;
+        case 24:
+          return int32_t((p[0] << 8) | (p[1] << 16) | (uint32_t(p[2]) << 24)) / 2147483648.0f;
+        default:
+          return int32_t(_le32(p)) / 2147483648.0f;
+      }
+    }
+
+    void
+    wav_file::read(const std::string& filename,
+        std::vector<float>& samples, double& samp_rate)
+    {
+      std::ifstream file(filename.c_str(), std::ios::binary);
+      if (!file) {
+        throw std::runtime_error("wav_file: Could not open " + filename);
+      }
+      std::vector<unsigned char> buf((std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>());
+      if (buf.size() < 12 || memcmp(&buf[0], "RIFF", 4) != 0 || memcmp(&buf[8], "WAVE", 4) != 0) {
+        throw std::runtime_error("wav_file: " + filename + " is not a WAVE file");
+      }
+
+      uint16_t format = 0, num_channels = 0, bits = 0;
+      const unsigned char* data = NULL;
+      size_t data_len = 0;
+      size_t pos = 12;
+      while (pos + 8 <= buf.size()) {
+        const unsigned char* chunk = &buf[pos];
+        const size_t chunk_len = std::min<size_t>(_le32(chunk + 4), buf.size() - pos - 8);
+        if (memcmp(chunk, "fmt ", 4) == 0 && chunk_len >= 16) {
+          format = _le16(chunk + 8);
+          num_channels = _le16(chunk + 10);
+          samp_rate = _le32(chunk + 12);
+          bits = _le16(chunk + 22);
+          if (format == FORMAT_EXTENSIBLE && chunk_len >= 26) {
+            format = _le16(chunk + 32);
+          }
+        } else if (memcmp(chunk, "data", 4) == 0) {
+          data = chunk + 8;
+          data_len = chunk_len;
+        }
+        // Chunks are padded to an even length
+        pos += 8 + chunk_len + (chunk_len & 1);
+      }
+
+      const bool supported = (format == FORMAT_PCM &&
+          (bits == 8 || bits == 16 || bits == 24 || bits == 32)) ||
+        (format == FORMAT_IEEE_FLOAT && bits == 32);
+      if (data == NULL || num_channels == 0 || !supported) {
+        throw std::runtime_error("wav_file: " + filename + " has no supported PCM data");
+      }
+
+      const size_t frame_len = num_channels * (bits / 8);
+      const size_t num_frames = data_len / frame_len;
+      samples.resize(num_frames);
+      for (size_t i = 0; i < num_frames; i++) {
+        float acc = 0.0f;
+        for (uint16_t c = 0; c < num_channels; c++) {
+          acc += _sample(data + (i * frame_len) + (c * (bits / 8)), format, bits);
+        }
+        samples[i] = acc / num_channels;
+      }
+    }
+
+  } /* namespace guitar */
+} /* namespace gr */
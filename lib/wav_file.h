@@ -0,0 +1,45 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GUITAR_WAV_FILE_H
+#define INCLUDED_GUITAR_WAV_FILE_H
+
+#include <string>
+#include <vector>
+
+namespace gr {
+  namespace guitar {
+
+    //  Minimal RIFF/WAVE reader for loading impulse responses. Reads
+    //  8, 16, 24 and 32 bit integer PCM and 32 bit float files, plain
+    //  or WAVE_FORMAT_EXTENSIBLE.
+    class wav_file
+    {
+     public:
+      //! Read \p filename into \p samples, scaled to [-1, 1] and mixed
+      //! down to mono. Throws std::runtime_error on unreadable files.
+      static void read(const std::string& filename,
+          std::vector<float>& samples, double& samp_rate);
+    };
+
+  } // namespace guitar
+} // namespace gr
+
+#endif /* INCLUDED_GUITAR_WAV_FILE_H */
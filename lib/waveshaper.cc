@@ -0,0 +1,159 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdexcept>
+#include "waveshaper.h"
+
+#define PI  3.14159265358979323846
+
+namespace gr {
+  namespace guitar {
+
+    waveshaper::waveshaper(const std::string& dist_func, double boost, size_t table_size)
+      : d_table_size(std::max<size_t>(table_size, 1)),
+        d_dist_func(NULL), d_wet_kernel(NULL), d_mix_kernel(NULL),
+        d_boost(boost), d_sat(1.0)
+    {
+      set_dist_func(dist_func);
+    }
+
+    bool
+    waveshaper::valid_dist_func(const std::string& dist_func)
+    {
+      return (dist_func == "L" || dist_func == "Q" || dist_func == "E" ||
+              dist_func == "I" || dist_func == "S");
+    }
+
+    void
+    waveshaper::set_dist_func(const std::string& dist_func)
+    {
+      if (dist_func == "L") {
+        d_dist_func = [](const float& x){
+          return x;
+        };
+        d_wet_kernel = &_kernel<linear_curve, false>;
+        d_mix_kernel = &_kernel<linear_curve, true>;
+      } else if (dist_func == "Q") {
+        d_dist_func = [](const float& x) -> float {
+          return (1.0 - (1.0 - x) * (1.0 - x));
+        };
+        d_wet_kernel = &_kernel<quadratic_curve, false>;
+        d_mix_kernel = &_kernel<quadratic_curve, true>;
+      } else if (dist_func == "E") {
+        d_dist_func = [](const float& x) -> float {
+          return ((1.0 - exp(-1.0 * x)) / exp(-0.5));
+        };
+        d_wet_kernel = &_kernel<table_curve, false>;
+        d_mix_kernel = &_kernel<table_curve, true>;
+      } else if (dist_func == "I") {
+        d_dist_func = [](const float& x) -> float {
+          return ((2 * x) / (1 + x));
+        };
+        d_wet_kernel = &_kernel<inverse_curve, false>;
+        d_mix_kernel = &_kernel<inverse_curve, true>;
+      } else if (dist_func == "S") {
+        d_dist_func = [](const float& x) -> float {
+          return sin((PI / 2) * x);
+        };
+        d_wet_kernel = &_kernel<table_curve, false>;
+        d_mix_kernel = &_kernel<table_curve, true>;
+      } else {
+        throw std::invalid_argument("distortion: Distortion function not supported.");
+      }
+      _build_table();
+    }
+
+    void
+    waveshaper::set_boost(double boost)
+    {
+      d_boost = boost;
+    }
+
+    void
+    waveshaper::_build_table()
+    {
+      // Find where the curve first reaches 1.0 so that the clip falls
+      // on the last table entry instead of between two entries
+      d_sat = 1.0;
+      if (d_dist_func(1.0) > 1.0) {
+        double lo = 0.0, hi = 1.0;
+        for (int i = 0; i < 60; i++) {
+          const double mid = 0.5 * (lo + hi);
+          if (d_dist_func(mid) >= 1.0) hi = mid; else lo = mid;
+        }
+        d_sat = hi;
+      }
+
+      d_table.resize(d_table_size + 1);
+      d_slope.resize(d_table_size);
+      for (size_t i = 0; i <= d_table_size; i++) {
+        d_table[i] = std::min<float>(d_dist_func(d_sat * i / d_table_size), 1.0);
+      }
+      d_table[d_table_size] = 1.0;
+      for (size_t i = 0; i < d_table_size; i++) {
+        d_slope[i] = d_table[i + 1] - d_table[i];
+      }
+    }
+
+    waveshaper::kernel_args
+    waveshaper::_args() const
+    {
+      kernel_args args;
+      args.boost = d_boost;
+      args.table = &d_table[0];
+      args.slope = &d_slope[0];
+      args.scale = d_boost * d_table_size / d_sat;
+      args.table_end = static_cast<float>(d_table_size);
+      args.table_last = static_cast<int>(d_table_size) - 1;
+      return args;
+    }
+
+    float
+    waveshaper::shape_exact(float x) const
+    {
+      const float sign = (x >= 0.0) ? 1.0 : -1.0;
+      const float mag = std::abs(x) * d_boost;
+      const float dist_x = (mag < 1.0) ? d_dist_func(mag) : 1.0;
+      return (sign * std::min<float>(dist_x, 1.0));
+    }
+
+    void
+    waveshaper::process(const float* in, float* out, size_t n,
+        bool enabled, double wet_gamma) const
+    {
+      if (!enabled) {
+        if (out != in) {
+          std::copy(in, in + n, out);
+        }
+        return;
+      }
+      if (wet_gamma == 1.0) {
+        d_wet_kernel(_args(), in, out, n, 1.0, 0.0);
+      } else {
+        d_mix_kernel(_args(), in, out, n, wet_gamma, 1.0 - wet_gamma);
+      }
+    }
+
+  } /* namespace guitar */
+} /* namespace gr */
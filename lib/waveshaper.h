@@ -0,0 +1,175 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GUITAR_WAVESHAPER_H
+#define INCLUDED_GUITAR_WAVESHAPER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace gr {
+  namespace guitar {
+
+    //  The waveshaper implements the memoryless distortion curves of
+    //  the distortion block. The input is boosted and its magnitude is
+    //  passed through the selected transfer function, which saturates
+    //  at 1.0. The sign of the input is preserved.
+    //
+    //  The magnitude is the float std::abs(x). The original distortion
+    //  block called an unqualified abs(), and where only the C
+    //  int abs(int) was in scope that truncated |x| to an integer, so
+    //  inputs below 1.0 in magnitude came out as silence. Builds that
+    //  picked that overload now distort those inputs like any other.
+    //
+    //  Transfer functions (for 0 <= x < 1):
+    //    L: x
+    //    Q: 1 - (1 - x)^2
+    //    E: (1 - exp(-x)) / exp(-0.5)
+    //    I: 2x / (1 + x)
+    //    S: sin(pi/2 * x)
+    //
+    //  L, Q and I are cheap enough to evaluate in closed form. E and S
+    //  are not evaluated per sample: set_dist_func() samples the curve
+    //  into a table of table_size + 1 points over [0, x_sat], where
+    //  x_sat <= 1 is the point at which the curve reaches 1.0, and the
+    //  table is interpolated linearly. The boost only scales the table
+    //  index, so set_boost() is free.
+    //
+    //  The linear interpolation error is at most h^2/8 * max|f''| with
+    //  h = x_sat/table_size. Of the tabulated curves, max|f''| is
+    //  e^0.5 for E and (pi/2)^2 for S, so the error against the exact
+    //  curve is below 0.31/table_size^2 plus float rounding, i.e.
+    //  about 3e-7 for the default size.
+    //
+    //  Every curve has its own whole-buffer kernel, instantiated from
+    //  a template for both the wet-only and the wet/dry mix case, so
+    //  the per-sample loop is fully inlined. set_dist_func() selects
+    //  the kernels through plain function pointers.
+    class waveshaper
+    {
+     public:
+      typedef float(*transfer_func)(const float&);
+
+      static const size_t DEFAULT_TABLE_SIZE = 1024;
+
+      waveshaper(const std::string& dist_func, double boost,
+          size_t table_size = DEFAULT_TABLE_SIZE);
+
+      //! True if dist_func names one of the transfer functions
+      static bool valid_dist_func(const std::string& dist_func);
+
+      //! Select the transfer function. Throws if dist_func is unknown.
+      void set_dist_func(const std::string& dist_func);
+      void set_boost(double boost);
+
+      //! Distort a single sample
+      float shape(float x) const
+      {
+        float y;
+        d_wet_kernel(_args(), &x, &y, 1, 1.0, 0.0);
+        return y;
+      }
+
+      //! Distort a single sample by evaluating the curve directly
+      float shape_exact(float x) const;
+
+      //! out = enabled ? (wet_gamma*shape(in) + (1-wet_gamma)*in) : in
+      void process(const float* in, float* out, size_t n,
+          bool enabled, double wet_gamma) const;
+
+     private:
+      // Everything a kernel reads, passed by value so that the loops
+      // do not reload it through this on every sample
+      struct kernel_args {
+        float boost;
+        const float* table;
+        const float* slope;
+        float scale;        // Converts |x| into a table position
+        float table_end;
+        int table_last;
+      };
+
+      typedef void(*kernel_func)(const kernel_args args,
+          const float* in, float* out, size_t n, float wet_gain, float dry_gain);
+
+      // Closed form curves for 0 <= u <= 1
+      struct linear_curve {
+        static float eval(float u) { return u; }
+      };
+      struct quadratic_curve {
+        static float eval(float u) { return u * (2.0f - u); }
+      };
+      struct inverse_curve {
+        static float eval(float u) { return (2.0f * u) / (1.0f + u); }
+      };
+
+      // Closed form curves are monotonic and reach 1.0 at u = 1, so
+      // clamping the input also clips the output
+      template<class curve>
+      static float _shape(const kernel_args& args, float x)
+      {
+        const float u = std::min(std::abs(x) * args.boost, 1.0f);
+        return std::copysign(curve::eval(u), x);
+      }
+
+      // Branch-free table interpolation
+      struct table_curve;
+
+      template<class curve, bool mix>
+      static void _kernel(const kernel_args args,
+          const float* in, float* out, size_t n, float wet_gain, float dry_gain)
+      {
+        for (size_t i = 0; i < n; i++) {
+          const float dry = in[i];
+          const float wet = _shape<curve>(args, dry);
+          out[i] = mix ? ((wet_gain * wet) + (dry_gain * dry)) : wet;
+        }
+      }
+
+      kernel_args _args() const;
+      void _build_table();
+
+      const size_t d_table_size;
+      transfer_func d_dist_func;
+      kernel_func d_wet_kernel;
+      kernel_func d_mix_kernel;
+      double d_boost;
+      double d_sat;       // Input at which the curve saturates
+      std::vector<float> d_table;
+      std::vector<float> d_slope;
+    };
+
+    template<>
+    inline float
+    waveshaper::_shape<waveshaper::table_curve>(const kernel_args& args, float x)
+    {
+      const float pos = std::min(std::abs(x) * args.scale, args.table_end);
+      const int idx = std::min(static_cast<int>(pos), args.table_last);
+      const float y = args.table[idx] + ((pos - idx) * args.slope[idx]);
+      return std::copysign(y, x);
+    }
+
+  } // namespace guitar
+} // namespace gr
+
+#endif /* INCLUDED_GUITAR_WAVESHAPER_H */
@@ -0,0 +1,165 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "work_stats.h"
+#if defined(GUITAR_WORK_STATS) && defined(GR_CTRLPORT)
+#include <gnuradio/rpcregisterhelpers.h>
+#endif
+#include <limits>
+
+namespace gr {
+  namespace guitar {
+
+    const double work_stats::PUBLISH_PERIOD = 1.0;
+
+#ifdef GUITAR_WORK_STATS
+
+    work_stats::work_stats():
+      d_calls(0), d_items(0), d_total_ns(0),
+      d_min_ns(std::numeric_limits<uint64_t>::max()), d_max_ns(0), d_worst_items(0),
+      d_port_blk(NULL), d_port(pmt::mp("stats"))
+    {
+    }
+
+    void
+    work_stats::setup_stats_port(gr::basic_block* blk)
+    {
+      blk->message_port_register_out(d_port);
+      d_port_blk = blk;
+      d_next_publish = std::chrono::steady_clock::now();
+    }
+
+    void
+    work_stats::setup_stats_rpc(gr::basic_block* blk)
+    {
+#ifdef GR_CTRLPORT
+      struct counter {
+        const char* name;
+        double (work_stats::*getter)() const;
+        const char* units;
+        const char* desc;
+      };
+      const counter counters[] = {
+        { "work_calls", &work_stats::work_calls, "calls", "Calls to work()" },
+        { "work_items", &work_stats::work_items, "items", "Output items of all calls" },
+        { "work_time_min", &work_stats::work_time_min, "ns", "Shortest call" },
+        { "work_time_avg", &work_stats::work_time_avg, "ns", "Mean call" },
+        { "work_time_max", &work_stats::work_time_max, "ns", "Longest call" },
+        { "work_time_per_item", &work_stats::work_time_per_item, "ns", "Mean time per item" },
+        { "worst_call_items", &work_stats::worst_call_items, "items", "Output items of the longest call" },
+      };
+      for (size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); i++) {
+        blk->add_rpc_variable(rpcbasic_sptr(new rpcbasic_register_get<work_stats, double>(
+          blk->alias(), counters[i].name, counters[i].getter,
+          pmt::mp(0.0), pmt::mp(1e9), pmt::mp(0.0),
+          counters[i].units, counters[i].desc, RPC_PRIVLVL_MIN, DISPTIME | DISPOPTSTRIP)));
+      }
+#endif
+    }
+
+    double
+    work_stats::work_calls() const
+    {
+      return _get(d_calls);
+    }
+
+    double
+    work_stats::work_items() const
+    {
+      return _get(d_items);
+    }
+
+    double
+    work_stats::work_time_min() const
+    {
+      return (_get(d_calls) > 0) ? _get(d_min_ns) : 0.0;
+    }
+
+    double
+    work_stats::work_time_avg() const
+    {
+      const uint64_t calls = _get(d_calls);
+      return (calls > 0) ? (_get(d_total_ns) / static_cast<double>(calls)) : 0.0;
+    }
+
+    double
+    work_stats::work_time_max() const
+    {
+      return _get(d_max_ns);
+    }
+
+    double
+    work_stats::work_time_per_item() const
+    {
+      const uint64_t items = _get(d_items);
+      return (items > 0) ? (_get(d_total_ns) / static_cast<double>(items)) : 0.0;
+    }
+
+    double
+    work_stats::worst_call_items() const
+    {
+      return _get(d_worst_items);
+    }
+
+    void
+    work_stats::_publish(std::chrono::steady_clock::time_point now)
+    {
+      d_port_blk->message_port_pub(d_port, stats_to_pmt());
+      d_next_publish = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(PUBLISH_PERIOD));
+    }
+
+#else
+
+    work_stats::work_stats() {}
+    void work_stats::setup_stats_port(gr::basic_block*) {}
+    void work_stats::setup_stats_rpc(gr::basic_block*) {}
+    double work_stats::work_calls() const { return 0.0; }
+    double work_stats::work_items() const { return 0.0; }
+    double work_stats::work_time_min() const { return 0.0; }
+    double work_stats::work_time_avg() const { return 0.0; }
+    double work_stats::work_time_max() const { return 0.0; }
+    double work_stats::work_time_per_item() const { return 0.0; }
+    double work_stats::worst_call_items() const { return 0.0; }
+
+#endif
+
+    pmt::pmt_t
+    work_stats::stats_to_pmt() const
+    {
+      pmt::pmt_t dict = pmt::make_dict();
+      dict = pmt::dict_add(dict, pmt::mp("work_calls"), pmt::from_double(work_calls()));
+      dict = pmt::dict_add(dict, pmt::mp("work_items"), pmt::from_double(work_items()));
+      dict = pmt::dict_add(dict, pmt::mp("work_time_min"), pmt::from_double(work_time_min()));
+      dict = pmt::dict_add(dict, pmt::mp("work_time_avg"), pmt::from_double(work_time_avg()));
+      dict = pmt::dict_add(dict, pmt::mp("work_time_max"), pmt::from_double(work_time_max()));
+      dict = pmt::dict_add(dict, pmt::mp("work_time_per_item"),
+        pmt::from_double(work_time_per_item()));
+      dict = pmt::dict_add(dict, pmt::mp("worst_call_items"),
+        pmt::from_double(worst_call_items()));
+      return dict;
+    }
+
+  } /* namespace guitar */
+} /* namespace gr */
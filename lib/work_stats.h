@@ -0,0 +1,157 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2018 Ashish Chaudhari.
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_WORK_STATS_H
+#define INCLUDED_WORK_STATS_H
+
+#include <gnuradio/block.h>
+#include <pmt/pmt.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+
+namespace gr {
+  namespace guitar {
+
+  /*!
+   * \brief counters of the calls to a block's work()
+   *
+   * Block implementations inherit from work_stats next to their public
+   * interface, and put a work_stats::timer at the top of work(). The
+   * counters are kept by the scheduler thread and can be read from any
+   * thread. Each is read whole, but they are not read as a set, so a
+   * reader can see one call counted in some and not yet in others.
+   *
+   * The counters are exported under the block alias through ControlPort
+   * (from setup_rpc()) and published as a dictionary on the "stats"
+   * message port about once a second (from work()).
+   *
+   * Everything compiles away unless GUITAR_WORK_STATS is defined: the
+   * timer is empty, the port is not registered and the getters return 0.
+   */
+  class work_stats
+  {
+  public:
+    //! Seconds between two messages on the stats port
+    static const double PUBLISH_PERIOD;
+
+    work_stats();
+    virtual ~work_stats() {}
+
+    //! Register the stats message port of \p blk. From the constructor.
+    void setup_stats_port(gr::basic_block* blk);
+
+    //! Export the counters under the alias of \p blk. From setup_rpc().
+    void setup_stats_rpc(gr::basic_block* blk);
+
+    //! Calls to work() so far
+    double work_calls() const;
+    //! Output items over all calls
+    double work_items() const;
+    //! Shortest, mean and longest time of a call, in ns
+    double work_time_min() const;
+    double work_time_avg() const;
+    double work_time_max() const;
+    //! Mean time per output item, in ns
+    double work_time_per_item() const;
+    //! Output items of the longest call
+    double worst_call_items() const;
+
+    //! All of the above as a PMT dictionary keyed by the getter names
+    pmt::pmt_t stats_to_pmt() const;
+
+    /*!
+     * \brief times one call to work() and counts its output items
+     */
+    class timer
+    {
+    public:
+#ifdef GUITAR_WORK_STATS
+      timer(work_stats& stats, int noutput_items):
+        d_stats(stats), d_nitems(noutput_items),
+        d_start(std::chrono::steady_clock::now()) {}
+
+      ~timer()
+      {
+        d_stats._record(d_start, std::chrono::steady_clock::now(), d_nitems);
+      }
+
+    private:
+      work_stats& d_stats;
+      const int d_nitems;
+      const std::chrono::steady_clock::time_point d_start;
+#else
+      timer(work_stats&, int) {}
+#endif
+    };
+
+  private:
+#ifdef GUITAR_WORK_STATS
+    // Written by work() only, so the updates need no read-modify-write
+    std::atomic<uint64_t> d_calls;
+    std::atomic<uint64_t> d_items;
+    std::atomic<uint64_t> d_total_ns;
+    std::atomic<uint64_t> d_min_ns;
+    std::atomic<uint64_t> d_max_ns;
+    std::atomic<uint64_t> d_worst_items;
+
+    gr::basic_block* d_port_blk;
+    pmt::pmt_t d_port;
+    std::chrono::steady_clock::time_point d_next_publish;
+
+    static uint64_t _get(const std::atomic<uint64_t>& counter)
+    {
+      return counter.load(std::memory_order_relaxed);
+    }
+
+    static void _put(std::atomic<uint64_t>& counter, uint64_t val)
+    {
+      counter.store(val, std::memory_order_relaxed);
+    }
+
+    void _record(std::chrono::steady_clock::time_point start,
+        std::chrono::steady_clock::time_point stop, int nitems)
+    {
+      const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+      _put(d_calls, _get(d_calls) + 1);
+      _put(d_items, _get(d_items) + nitems);
+      _put(d_total_ns, _get(d_total_ns) + ns);
+      if (ns < _get(d_min_ns)) {
+        _put(d_min_ns, ns);
+      }
+      if (ns > _get(d_max_ns)) {
+        _put(d_max_ns, ns);
+        _put(d_worst_items, nitems);
+      }
+      if (d_port_blk && stop >= d_next_publish) {
+        _publish(stop);
+      }
+    }
+
+    void _publish(std::chrono::steady_clock::time_point now);
+#endif
+  };
+
+  } /* namespace guitar */
+} /* namespace gr */
+
+#endif /* INCLUDED_WORK_STATS_H */
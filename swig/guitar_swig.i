@@ -11,10 +11,14 @@
 #include "guitar/iir_interpolator.h"
 #include "guitar/iir_decimator.h"
 #include "guitar/shelving_filter.h"
+#include "guitar/parametric_eq.h"
 #include "guitar/distortion.h"
+#include "guitar/oversampled_distortion.h"
 #include "guitar/wah_filter.h"
 #include "guitar/flanger.h"
 #include "guitar/reverb.h"
+#include "guitar/multichannel_reverb.h"
+#include "guitar/convolution_reverb.h"
 %}
 
 
@@ -24,8 +28,13 @@ GR_SWIG_BLOCK_MAGIC2(guitar, iir_interpolator);
 GR_SWIG_BLOCK_MAGIC2(guitar, iir_decimator);
 %include "guitar/shelving_filter.h"
 GR_SWIG_BLOCK_MAGIC2(guitar, shelving_filter);
+%template(guitar_string_vector) std::vector<std::string>;
+%include "guitar/parametric_eq.h"
+GR_SWIG_BLOCK_MAGIC2(guitar, parametric_eq);
 %include "guitar/distortion.h"
 GR_SWIG_BLOCK_MAGIC2(guitar, distortion);
+%include "guitar/oversampled_distortion.h"
+GR_SWIG_BLOCK_MAGIC2(guitar, oversampled_distortion);
 %include "guitar/wah_filter.h"
 GR_SWIG_BLOCK_MAGIC2(guitar, wah_filter);
 %include "guitar/flanger.h"
@@ -33,3 +42,7 @@ GR_SWIG_BLOCK_MAGIC2(guitar, flanger);
 
 %include "guitar/reverb.h"
 GR_SWIG_BLOCK_MAGIC2(guitar, reverb);
+%include "guitar/multichannel_reverb.h"
+GR_SWIG_BLOCK_MAGIC2(guitar, multichannel_reverb);
+%include "guitar/convolution_reverb.h"
+GR_SWIG_BLOCK_MAGIC2(guitar, convolution_reverb);